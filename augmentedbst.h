@@ -0,0 +1,365 @@
+#ifndef AUGMENTEDBST_H
+#define AUGMENTEDBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
+#include "avlbst.h"
+
+/*
+ * Monoids for AugmentedAVLTree. A monoid names its aggregate type as
+ * value_type and provides identity(), lift(key, value) for a single item
+ * and an associative combine(a, b), where a covers the smaller keys.
+ * combine need not be commutative.
+ */
+
+/**
+* Sum of the values.
+*/
+template <typename Key, typename Value>
+struct SumMonoid
+{
+    typedef Value value_type;
+    Value identity() const { return Value(); }
+    Value lift(const Key&, const Value& value) const { return value; }
+    Value combine(const Value& a, const Value& b) const { return a + b; }
+};
+
+/**
+* Smallest value. Needs std::numeric_limits<Value>.
+*/
+template <typename Key, typename Value>
+struct MinMonoid
+{
+    typedef Value value_type;
+    Value identity() const { return std::numeric_limits<Value>::max(); }
+    Value lift(const Key&, const Value& value) const { return value; }
+    Value combine(const Value& a, const Value& b) const { return std::min(a, b); }
+};
+
+/**
+* Largest value. Needs std::numeric_limits<Value>.
+*/
+template <typename Key, typename Value>
+struct MaxMonoid
+{
+    typedef Value value_type;
+    Value identity() const { return std::numeric_limits<Value>::lowest(); }
+    Value lift(const Key&, const Value& value) const { return value; }
+    Value combine(const Value& a, const Value& b) const { return std::max(a, b); }
+};
+
+/**
+* Number of items.
+*/
+template <typename Key, typename Value>
+struct CountMonoid
+{
+    typedef size_t value_type;
+    size_t identity() const { return 0; }
+    size_t lift(const Key&, const Value&) const { return 1; }
+    size_t combine(size_t a, size_t b) const { return a + b; }
+};
+
+/**
+* An AVL node that also stores the aggregate of its whole subtree.
+*/
+template <typename Key, typename Value, typename Aggregate>
+class AugmentedAVLNode : public AVLNode<Key, Value>
+{
+public:
+    AugmentedAVLNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent, const Aggregate& aggregate);
+    AugmentedAVLNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent, const Aggregate& aggregate);
+    virtual ~AugmentedAVLNode();
+
+    const Aggregate& getAggregate() const;
+    void setAggregate(const Aggregate& aggregate);
+
+    virtual AugmentedAVLNode<Key, Value, Aggregate>* getParent() const override;
+    virtual AugmentedAVLNode<Key, Value, Aggregate>* getLeft() const override;
+    virtual AugmentedAVLNode<Key, Value, Aggregate>* getRight() const override;
+
+    virtual AugmentedAVLNode<Key, Value, Aggregate>* clone(Node<Key, Value>* parent) const override;
+    virtual AugmentedAVLNode<Key, Value, Aggregate>* moveInto(void* where, Node<Key, Value>* parent) override;
+    virtual size_t nodeSize() const override;
+
+protected:
+    Aggregate aggregate_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AugmentedAVLNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate>::AugmentedAVLNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent, const Aggregate& aggregate) :
+    AVLNode<Key, Value>(key, value, parent), aggregate_(aggregate)
+{
+
+}
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate>::AugmentedAVLNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent, const Aggregate& aggregate) :
+    AVLNode<Key, Value>(key, std::move(value), parent), aggregate_(aggregate)
+{
+
+}
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate>::~AugmentedAVLNode()
+{
+
+}
+
+/**
+* Returns the aggregate of the subtree rooted here.
+*/
+template<class Key, class Value, class Aggregate>
+const Aggregate& AugmentedAVLNode<Key, Value, Aggregate>::getAggregate() const
+{
+    return aggregate_;
+}
+
+template<class Key, class Value, class Aggregate>
+void AugmentedAVLNode<Key, Value, Aggregate>::setAggregate(const Aggregate& aggregate)
+{
+    aggregate_ = aggregate;
+}
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate> *AugmentedAVLNode<Key, Value, Aggregate>::getParent() const
+{
+    return static_cast<AugmentedAVLNode<Key, Value, Aggregate>*>(this->parent_);
+}
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate> *AugmentedAVLNode<Key, Value, Aggregate>::getLeft() const
+{
+    return static_cast<AugmentedAVLNode<Key, Value, Aggregate>*>(this->left_);
+}
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate> *AugmentedAVLNode<Key, Value, Aggregate>::getRight() const
+{
+    return static_cast<AugmentedAVLNode<Key, Value, Aggregate>*>(this->right_);
+}
+
+/**
+* Copies the item, balance and aggregate into a new node.
+*/
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate> *AugmentedAVLNode<Key, Value, Aggregate>::clone(Node<Key, Value>* parent) const
+{
+    AugmentedAVLNode<Key, Value, Aggregate>* copy = new AugmentedAVLNode<Key, Value, Aggregate>(
+        this->item_.first, this->item_.second, static_cast<AVLNode<Key, Value>*>(parent), aggregate_);
+    copy->setBalance(this->balance_);
+    return copy;
+}
+
+template<class Key, class Value, class Aggregate>
+AugmentedAVLNode<Key, Value, Aggregate> *AugmentedAVLNode<Key, Value, Aggregate>::moveInto(void* where, Node<Key, Value>* parent)
+{
+    AugmentedAVLNode<Key, Value, Aggregate>* copy = new(where) AugmentedAVLNode<Key, Value, Aggregate>(
+        this->item_.first, std::move(this->item_.second), static_cast<AVLNode<Key, Value>*>(parent), aggregate_);
+    copy->setBalance(this->balance_);
+    return copy;
+}
+
+template<class Key, class Value, class Aggregate>
+size_t AugmentedAVLNode<Key, Value, Aggregate>::nodeSize() const
+{
+    return sizeof(AugmentedAVLNode<Key, Value, Aggregate>);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AugmentedAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVL tree whose nodes keep the Monoid aggregate of their subtree, so
+* the aggregate over any key range takes O(log n) instead of a scan.
+* Aggregates are kept up to date by insert, remove and every rotation.
+*
+* Values must only change through insert(); writing through an iterator
+* would leave the aggregates stale. For that reason operator[] only
+* returns const references here.
+*/
+template <class Key, class Value, class Monoid, class Compare = std::less<Key> >
+class AugmentedAVLTree : public AVLTree<Key, Value, Compare>
+{
+public:
+    typedef typename Monoid::value_type aggregate_type;
+
+    AugmentedAVLTree();
+    explicit AugmentedAVLTree(const Monoid& monoid);
+    AugmentedAVLTree(const Monoid& monoid, const Compare& comp);
+
+    // Aggregate of the items with lo <= key < hi, in key order
+    aggregate_type aggregate(const Key& lo, const Key& hi) const;
+    // Aggregate of the whole tree
+    aggregate_type aggregate() const;
+
+    Value const & operator[](const Key& key) const;
+
+protected:
+    typedef AugmentedAVLNode<Key, Value, aggregate_type> AugNode;
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual void fixAugment(AVLNode<Key, Value>* n);
+    virtual void augmentPath(AVLNode<Key, Value>* n);
+
+    // identity for an empty subtree
+    aggregate_type subtreeAggregate(Node<Key, Value>* n) const;
+    aggregate_type lift(Node<Key, Value>* n) const;
+
+    Monoid monoid_;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the AugmentedAVLTree class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, class Monoid, class Compare>
+AugmentedAVLTree<Key, Value, Monoid, Compare>::AugmentedAVLTree() :
+    AVLTree<Key, Value, Compare>(), monoid_()
+{
+
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+AugmentedAVLTree<Key, Value, Monoid, Compare>::AugmentedAVLTree(const Monoid& monoid) :
+    AVLTree<Key, Value, Compare>(), monoid_(monoid)
+{
+
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+AugmentedAVLTree<Key, Value, Monoid, Compare>::AugmentedAVLTree(const Monoid& monoid, const Compare& comp) :
+    AVLTree<Key, Value, Compare>(comp), monoid_(monoid)
+{
+
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+typename AugmentedAVLTree<Key, Value, Monoid, Compare>::aggregate_type
+AugmentedAVLTree<Key, Value, Monoid, Compare>::subtreeAggregate(Node<Key, Value>* n) const
+{
+    if(n == NULL) {
+        return monoid_.identity();
+    }
+    return static_cast<AugNode*>(n)->getAggregate();
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+typename AugmentedAVLTree<Key, Value, Monoid, Compare>::aggregate_type
+AugmentedAVLTree<Key, Value, Monoid, Compare>::lift(Node<Key, Value>* n) const
+{
+    return monoid_.lift(n->getKey(), n->getValue());
+}
+
+/**
+* New nodes are leaves, so their aggregate is just their own item.
+*/
+template<class Key, class Value, class Monoid, class Compare>
+AVLNode<Key, Value>* AugmentedAVLTree<Key, Value, Monoid, Compare>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    return new AugNode(key, value, parent, monoid_.lift(key, value));
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+void AugmentedAVLTree<Key, Value, Monoid, Compare>::fixAugment(AVLNode<Key, Value>* n)
+{
+    static_cast<AugNode*>(n)->setAggregate(monoid_.combine(
+        monoid_.combine(subtreeAggregate(n->getLeft()), lift(n)), subtreeAggregate(n->getRight())));
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+void AugmentedAVLTree<Key, Value, Monoid, Compare>::augmentPath(AVLNode<Key, Value>* n)
+{
+    for(; n != NULL; n = n->getParent()) {
+        fixAugment(n);
+    }
+}
+
+/**
+* Finds the highest node inside [lo, hi), then walks down each side of
+* it. On the way to lo, every node at or above lo brings itself and its
+* whole right subtree; on the way to hi, every node below hi brings its
+* whole left subtree and itself. Each step is one stored aggregate, so
+* this takes O(log n) combines.
+*/
+template<class Key, class Value, class Monoid, class Compare>
+typename AugmentedAVLTree<Key, Value, Monoid, Compare>::aggregate_type
+AugmentedAVLTree<Key, Value, Monoid, Compare>::aggregate(const Key& lo, const Key& hi) const
+{
+    Node<Key, Value>* split = this->root_;
+    while(split != NULL) {
+        if(this->comp_(split->getKey(), lo)) {
+            split = split->getRight();
+        }
+        else if(!this->comp_(split->getKey(), hi)) {
+            split = split->getLeft();
+        }
+        else {
+            break;
+        }
+    }
+    if(split == NULL) {
+        return monoid_.identity();
+    }
+
+    // everything collected here is larger than what is still below
+    aggregate_type leftPart = monoid_.identity();
+    for(Node<Key, Value>* n = split->getLeft(); n != NULL; ) {
+        if(this->comp_(n->getKey(), lo)) {
+            n = n->getRight();
+        }
+        else {
+            leftPart = monoid_.combine(monoid_.combine(lift(n), subtreeAggregate(n->getRight())), leftPart);
+            n = n->getLeft();
+        }
+    }
+
+    // everything collected here is smaller than what is still below
+    aggregate_type rightPart = monoid_.identity();
+    for(Node<Key, Value>* n = split->getRight(); n != NULL; ) {
+        if(this->comp_(n->getKey(), hi)) {
+            rightPart = monoid_.combine(rightPart, monoid_.combine(subtreeAggregate(n->getLeft()), lift(n)));
+            n = n->getRight();
+        }
+        else {
+            n = n->getLeft();
+        }
+    }
+
+    return monoid_.combine(monoid_.combine(leftPart, lift(split)), rightPart);
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+typename AugmentedAVLTree<Key, Value, Monoid, Compare>::aggregate_type
+AugmentedAVLTree<Key, Value, Monoid, Compare>::aggregate() const
+{
+    return subtreeAggregate(this->root_);
+}
+
+template<class Key, class Value, class Monoid, class Compare>
+Value const & AugmentedAVLTree<Key, Value, Monoid, Compare>::operator[](const Key& key) const
+{
+    return BinarySearchTree<Key, Value, Compare>::operator[](key);
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the AugmentedAVLTree class.
+  ---------------------------------------------
+*/
+
+#endif
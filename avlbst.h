@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <cstdint>
 #include <algorithm>
+#include <vector>
 #include "bst.h"
 
 struct KeyError { };
@@ -21,6 +22,7 @@ class AVLNode : public Node<Key, Value>
 public:
     // Constructor/destructor.
     AVLNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    AVLNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent);
     virtual ~AVLNode();
 
     // Getter/setter for the node's height.
@@ -35,6 +37,10 @@ public:
     virtual AVLNode<Key, Value>* getLeft() const override;
     virtual AVLNode<Key, Value>* getRight() const override;
 
+    virtual AVLNode<Key, Value>* clone(Node<Key, Value>* parent) const override;
+    virtual AVLNode<Key, Value>* moveInto(void* where, Node<Key, Value>* parent) override;
+    virtual size_t nodeSize() const override;
+
 protected:
     int8_t balance_;    // effectively a signed char
 };
@@ -55,6 +61,13 @@ AVLNode<Key, Value>::AVLNode(const Key& key, const Value& value, AVLNode<Key, Va
 
 }
 
+template<class Key, class Value>
+AVLNode<Key, Value>::AVLNode(const Key& key, Value&& value, AVLNode<Key, Value> *parent) :
+    Node<Key, Value>(key, std::move(value), parent), balance_(0)
+{
+
+}
+
 /**
 * A destructor which does nothing.
 */
@@ -119,6 +132,31 @@ AVLNode<Key, Value> *AVLNode<Key, Value>::getRight() const
     return static_cast<AVLNode<Key, Value>*>(this->right_);
 }
 
+/**
+* Copies the item and the balance into a new AVLNode.
+*/
+template<class Key, class Value>
+AVLNode<Key, Value> *AVLNode<Key, Value>::clone(Node<Key, Value>* parent) const
+{
+    AVLNode<Key, Value>* copy = new AVLNode<Key, Value>(this->item_.first, this->item_.second, static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(balance_);
+    return copy;
+}
+
+template<class Key, class Value>
+AVLNode<Key, Value> *AVLNode<Key, Value>::moveInto(void* where, Node<Key, Value>* parent)
+{
+    AVLNode<Key, Value>* copy = new(where) AVLNode<Key, Value>(this->item_.first, std::move(this->item_.second), static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(balance_);
+    return copy;
+}
+
+template<class Key, class Value>
+size_t AVLNode<Key, Value>::nodeSize() const
+{
+    return sizeof(AVLNode<Key, Value>);
+}
+
 
 /*
   -----------------------------------------------
@@ -127,32 +165,89 @@ AVLNode<Key, Value> *AVLNode<Key, Value>::getRight() const
 */
 
 
-template <class Key, class Value>
-class AVLTree : public BinarySearchTree<Key, Value>
+template <class Key, class Value, class Compare = std::less<Key> >
+class AVLTree : public BinarySearchTree<Key, Value, Compare>
 {
 public:
+    AVLTree();
+    explicit AVLTree(const Compare& comp);
     virtual void insert (const std::pair<const Key, Value> &new_item); // TODO
-    virtual void remove(const Key& key);  // TODO
 protected:
+    virtual void removeNode(Node<Key, Value>* temp);
     virtual void nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2);
+    // Cuts the range out with two splits and one join instead of
+    // rebalancing after every node, so it takes O(log n + k).
+    virtual void eraseRange(Node<Key, Value>* first, Node<Key, Value>* last);
+
+    // Allocates the node for a new item. Trees built on AVLTree that
+    // need extra per-node data override this to allocate a subclass.
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+
+    // Like BinarySearchTree::linkBalanced, but also sets each node's
+    // balance and reports the height of the subtree it built.
+    static AVLNode<Key, Value>* linkBalancedAVL(std::vector<Node<Key, Value>*>& nodes, size_t lo, size_t hi, AVLNode<Key, Value>* parent, int& height);
+
+    // Hooks for trees that keep per-subtree data in their nodes.
+    // fixAugment recomputes one node from its children and augmentPath
+    // does that for n and every ancestor. Rotations call fixAugment;
+    // insert and remove call augmentPath where the tree changed. Both
+    // do nothing here.
+    virtual void fixAugment(AVLNode<Key, Value>* n);
+    virtual void augmentPath(AVLNode<Key, Value>* n);
 
     // Add helper functions here
 
-    // helper function to balance the tree after an insertion or deletion
+    // Links a new leaf n under parent, then updates the augmentation and
+    // rebalances. Trees that choose their own insert position use this.
+    void attachLeaf(AVLNode<Key, Value>* parent, bool goLeft, AVLNode<Key, Value>* n);
+
+    // helper functions to walk back up the tree and rebalance after an insertion or deletion
     void balanceTree(AVLNode<Key, Value>* tempParent, int rol);
-    // void balanceTreeForInsert(AVLNode<Key, Value>* tempParent, int rol);
-    // void balanceTreeForRemove(AVLNode<Key, Value>* tempParent, int rol);
-    void rightRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Value>* tempParent);
-    void leftRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Value>* tempParent);
+    void balanceTreeForRemove(AVLNode<Key, Value>* tempParent, int rol);
+    void rightRotate(AVLNode<Key, Value>* z);
+    void leftRotate(AVLNode<Key, Value>* z);
+
+    // Split and join work on standalone AVL trees (root parent NULL) and
+    // pass their heights along, since nodes only store balances.
+    // Height of the subtree at n, following the taller side: O(log n)
+    static int subtreeHeight(AVLNode<Key, Value>* n);
+    // Height of n's left or right subtree, given n's height: O(1)
+    static int childHeight(AVLNode<Key, Value>* n, int height, bool left);
+    // Splits the tree holding x into the nodes before x and the nodes
+    // after x, and unlinks x.
+    void splitAt(AVLNode<Key, Value>* x, AVLNode<Key, Value>*& before, int& beforeHeight,
+                 AVLNode<Key, Value>*& after, int& afterHeight);
+    // Joins left, k and right, in that key order, into one tree and
+    // returns its root. Takes O(|leftHeight - rightHeight| + 1).
+    AVLNode<Key, Value>* join(AVLNode<Key, Value>* left, int leftHeight, AVLNode<Key, Value>* k,
+                              AVLNode<Key, Value>* right, int rightHeight, int& height);
 
 };
 
+/**
+* Constructs an empty AVL tree.
+*/
+template<class Key, class Value, class Compare>
+AVLTree<Key, Value, Compare>::AVLTree() : BinarySearchTree<Key, Value, Compare>()
+{
+
+}
+
+/**
+* Constructs an empty AVL tree ordered by the given comparator.
+*/
+template<class Key, class Value, class Compare>
+AVLTree<Key, Value, Compare>::AVLTree(const Compare& comp) : BinarySearchTree<Key, Value, Compare>(comp)
+{
+
+}
+
 /*
  * Recall: If key is already in the tree, you should 
  * overwrite the current value with the updated value.
  */
-template<class Key, class Value>
-void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::insert (const std::pair<const Key, Value> &new_item)
 {
     // TODO 
 
@@ -161,332 +256,371 @@ void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
     // base case: if tree is empty 
     if(this->root_ == nullptr){
       // just add new node from root 
-      this->root_ = new AVLNode<Key, Value>(new_item.first, new_item.second, nullptr); // dynamically allocate a new node to insert 
+      this->root_ = createNode(new_item.first, new_item.second, nullptr); // dynamically allocate a new node to insert 
+      this->nodeLinked(this->root_);
       return; // done
     
     }
 
-    AVLNode<Key, Value>* temp = static_cast<AVLNode<Key, Value>*>(this->root_); // start temp at the root 
-    AVLNode<Key, Value>* tempParent = nullptr; // so that we can insert the node later  
+    Node<Key, Value>* parent = nullptr; // so that we can insert the node later  
+    bool goLeft = false; // which side of the parent the new node goes on 
 
-    // A. walk the tree until find an empty location 
-    while (temp != nullptr){
-      tempParent = temp; // to not fall off the end of the tree and have temp be nullptr after 
-      // go left if value is less than node --> value here would be the key bc that's how BST stores nodes 
-      if(new_item.first < temp->getKey()){
-        // tempParent = temp; // update parent
-        temp = temp->getLeft();
-      }
-      // right if greater than node
-      else if(new_item.first > temp->getKey()){
-        // tempParent = temp; // update parent
-        temp = temp->getRight();
-      }
-      // else the value is equal --> key is already in the tree so overwrite !!
-      else{
-        temp->setValue(new_item.second); // set new value
-        return; // overwritten so now done 
-      }
+    // A. walk the tree until we find the key or an empty location 
+    Node<Key, Value>* temp = this->descend(new_item.first, parent, goLeft);
+
+    // key is already in the tree so overwrite !!
+    if(temp != nullptr){
+      temp->setValue(new_item.second); // set new value
+      augmentPath(static_cast<AVLNode<Key, Value>*>(temp));
+      return; // overwritten so now done 
     }
 
     // B. insert the new node
-    AVLNode<Key, Value>* nodeToInsert = new AVLNode<Key, Value>(new_item.first, new_item.second, tempParent); // create a new node 
+    AVLNode<Key, Value>* tempParent = static_cast<AVLNode<Key, Value>*>(parent);
+    AVLNode<Key, Value>* nodeToInsert = createNode(new_item.first, new_item.second, tempParent); // create a new node 
 
-    // if item's key is < parent's key
-    if(new_item.first < tempParent->getKey()){  
-      tempParent->setLeft(nodeToInsert); // go left 
-      // tempParent->updateBalance(1); // update the balance with the added node of left side
-    
-      // 2. Balance the tree 
-      balanceTree(tempParent, 1); 
+    // 2. hook it in and balance the tree 
+    attachLeaf(tempParent, goLeft, nodeToInsert);
+
+    return;
+}
+
+// helper function to hang a new leaf off parent and rebalance up from there
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::attachLeaf(AVLNode<Key, Value>* parent, bool goLeft, AVLNode<Key, Value>* n)
+{
+    if(goLeft){  
+      parent->setLeft(n); // go left 
     }
-    // its greater than so go right
     else{
-      tempParent->setRight(nodeToInsert); // go right 
-      // tempParent->updateBalance(-1); // update the balance with the added node of right side
-    
-      // 2. Balance the tree 
-      balanceTree(tempParent, -1); 
-      // balanceTreeForInsert(tempParent, -1);
+      parent->setRight(n); // go right 
     }
+    this->nodeLinked(n);
+    augmentPath(parent);
+    balanceTree(parent, goLeft ? 1 : -1); 
+}
 
-    return;
+template<class Key, class Value, class Compare>
+AVLNode<Key, Value>* AVLTree<Key, Value, Compare>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    return new AVLNode<Key, Value>(key, value, parent);
 }
 
-// helper function to balance the tree: 
-template<class Key, class Value>
-void AVLTree<Key, Value>:: balanceTree(AVLNode<Key, Value>* tempParent, int rol){ // rol stores the number that node added to the tree like +1 is added as right kid or -1 is left 
-    
-  //start at tempParent and walk upward to balance along that path
-  AVLNode<Key, Value>* treeIterator = tempParent; // start at tempParent to iterate the tree 
+template<class Key, class Value, class Compare>
+AVLNode<Key, Value>* AVLTree<Key, Value, Compare>::linkBalancedAVL(std::vector<Node<Key, Value>*>& nodes, size_t lo, size_t hi, AVLNode<Key, Value>* parent, int& height)
+{
+    if(lo >= hi){
+      height = 0;
+      return nullptr;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    AVLNode<Key, Value>* subRoot = static_cast<AVLNode<Key, Value>*>(nodes[mid]);
+    int leftHeight = 0;
+    int rightHeight = 0;
+    subRoot->setParent(parent);
+    subRoot->setLeft(linkBalancedAVL(nodes, lo, mid, subRoot, leftHeight));
+    subRoot->setRight(linkBalancedAVL(nodes, mid + 1, hi, subRoot, rightHeight));
+    subRoot->setBalance((int8_t)(leftHeight - rightHeight));
+    height = std::max(leftHeight, rightHeight) + 1;
+    return subRoot;
+}
 
-  // base case: 
-  if(treeIterator == nullptr) { //  || tempParent->getBalance() == 0) {
-    return; // temp is the root so its all good 
-  }
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::fixAugment(AVLNode<Key, Value>*)
+{
 
-  // 1. find balance factor 
-  treeIterator->updateBalance(rol); // set the balance of the iterator!
-  int8_t balanceFactor = treeIterator->getBalance(); 
+}
 
-  // if tree IS balanced
-  if(balanceFactor == 0){
-    return; // done !
-  }
-  // if tree is NOT balanced 
-  if(balanceFactor < -1){ // heavy on right kids 
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::augmentPath(AVLNode<Key, Value>*)
+{
 
-    AVLNode<Key, Value>* rightKid = treeIterator->getRight(); // get the right kid
-    
-    if(rightKid != nullptr && rightKid->getBalance() > 0){
-      // case for RL 
-      // rightRotate(rightKid, treeIterator);
-      rightRotate(nullptr, rightKid);
+}
+
+/**
+* Splits the tree around first, splits what follows around last, frees
+* first and everything between, then joins the outer pieces back with
+* last in the middle. Each split is a series of joins whose costs add
+* up to O(log n), so the whole range goes in O(log n + k).
+*/
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::eraseRange(Node<Key, Value>* first, Node<Key, Value>* last)
+{
+    AVLNode<Key, Value>* before = nullptr;
+    AVLNode<Key, Value>* after = nullptr;
+    int beforeHeight = 0;
+    int afterHeight = 0;
+    splitAt(static_cast<AVLNode<Key, Value>*>(first), before, beforeHeight, after, afterHeight);
+    this->destroyNode(first);
+
+    if(last == nullptr){
+      this->helpClear(after);
+      this->root_ = before;
+      return;
     }
-    // else {
-      // case for RR 
-      leftRotate(nullptr, treeIterator);
-      return; // the end so return 
-    // }
-  }
-  else if(balanceFactor > 1){ // heavy on left kids 
-    
-    AVLNode<Key, Value>* leftKid = treeIterator->getLeft(); // get the right kid
-    
-    if(leftKid != nullptr && leftKid->getBalance() < 0){
-      // case for LR 
-      // leftRotate(leftKid, treeIterator);
-      leftRotate(nullptr, leftKid);
+
+    AVLNode<Key, Value>* middle = nullptr;
+    AVLNode<Key, Value>* rest = nullptr;
+    int middleHeight = 0;
+    int restHeight = 0;
+    splitAt(static_cast<AVLNode<Key, Value>*>(last), middle, middleHeight, rest, restHeight);
+    this->helpClear(middle);
+
+    int height = 0;
+    this->root_ = join(before, beforeHeight, static_cast<AVLNode<Key, Value>*>(last), rest, restHeight, height);
+}
+
+template<class Key, class Value, class Compare>
+int AVLTree<Key, Value, Compare>::subtreeHeight(AVLNode<Key, Value>* n)
+{
+    int height = 0;
+    while(n != nullptr){
+      ++height;
+      n = (n->getBalance() < 0) ? n->getRight() : n->getLeft();
     }
-    // else {
-      // case for LL 
-      rightRotate(nullptr, treeIterator);
-      return; // the end so return 
-    // }
-  }
+    return height;
+}
 
-  // get grand parent
-  AVLNode<Key, Value>* tempGrandParent = treeIterator->getParent(); // tempGrandParent stores the grandparent of temp 
-  
-  if(tempGrandParent == nullptr){
-    return; // we reached the root ! done !
-  }
+template<class Key, class Value, class Compare>
+int AVLTree<Key, Value, Compare>::childHeight(AVLNode<Key, Value>* n, int height, bool left)
+{
+    // balance is left height minus right height
+    bool taller = left ? (n->getBalance() >= 0) : (n->getBalance() <= 0);
+    return taller ? height - 1 : height - 2;
+}
 
-  // get the next rol 
-  int r; 
-  if(treeIterator == tempGrandParent->getLeft()){
-    r = 1; // then left kids heavier
-  }
-  else {
-    r = -1; // then right kids heavier 
-  }
-  
-  // recursive call: 
-  balanceTree(tempGrandParent, r); // move up the tree along the path tyo the root
+/**
+* Walks up from x, then back down the same path: each ancestor joins
+* whichever piece lies on the far side of x with its own other subtree,
+* so the pieces stay valid AVL trees the whole way up.
+*/
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::splitAt(AVLNode<Key, Value>* x, AVLNode<Key, Value>*& before, int& beforeHeight,
+                                           AVLNode<Key, Value>*& after, int& afterHeight)
+{
+    // an AVL tree of 2^64 nodes is under 96 levels tall
+    AVLNode<Key, Value>* path[128];
+    int heights[128];
+    size_t depth = 0;
+    for(AVLNode<Key, Value>* n = x; n != nullptr; n = n->getParent()){
+      path[depth++] = n;
+    }
+    heights[depth - 1] = subtreeHeight(path[depth - 1]);
+    for(size_t i = depth - 1; i > 0; --i){
+      heights[i - 1] = childHeight(path[i], heights[i], path[i - 1] == path[i]->getLeft());
+    }
+
+    before = x->getLeft();
+    beforeHeight = childHeight(x, heights[0], true);
+    after = x->getRight();
+    afterHeight = childHeight(x, heights[0], false);
+    if(before != nullptr){
+      before->setParent(nullptr);
+    }
+    if(after != nullptr){
+      after->setParent(nullptr);
+    }
+
+    for(size_t i = 1; i < depth; ++i){
+      AVLNode<Key, Value>* t = path[i];
+      bool fromLeft = (path[i - 1] == t->getLeft());
+      AVLNode<Key, Value>* other = fromLeft ? t->getRight() : t->getLeft();
+      int otherHeight = childHeight(t, heights[i], !fromLeft);
+      if(other != nullptr){
+        other->setParent(nullptr);
+      }
+      if(fromLeft){
+        after = join(after, afterHeight, t, other, otherHeight, afterHeight);
+      }
+      else{
+        before = join(other, otherHeight, t, before, beforeHeight, beforeHeight);
+      }
+    }
 
-  return; // balanceFactor is zero and good so return !
+    x->setParent(nullptr);
+    x->setLeft(nullptr);
+    x->setRight(nullptr);
 }
 
+/**
+* When the heights are close, k becomes the root. Otherwise k goes down
+* the inner spine of the taller tree to the first subtree no more than
+* one taller than the shorter tree, takes that subtree and the shorter
+* tree as its children, and the insertion retrace fixes the path above,
+* since that spot grew by exactly one level.
+*
+* The retrace's rotations write root_, so root_ is pointed at the tree
+* being joined into for the duration; callers set root_ afterwards.
+*/
+template<class Key, class Value, class Compare>
+AVLNode<Key, Value>* AVLTree<Key, Value, Compare>::join(AVLNode<Key, Value>* left, int leftHeight, AVLNode<Key, Value>* k,
+                                                         AVLNode<Key, Value>* right, int rightHeight, int& height)
+{
+    bool intoLeft = leftHeight > rightHeight + 1;
+    bool intoRight = rightHeight > leftHeight + 1;
+    if(!intoLeft && !intoRight){
+      k->setParent(nullptr);
+      k->setLeft(left);
+      k->setRight(right);
+      if(left != nullptr){
+        left->setParent(k);
+      }
+      if(right != nullptr){
+        right->setParent(k);
+      }
+      k->setBalance((int8_t)(leftHeight - rightHeight));
+      fixAugment(k);
+      height = std::max(leftHeight, rightHeight) + 1;
+      return k;
+    }
 
+    AVLNode<Key, Value>* top = intoLeft ? left : right;
+    int topHeight = intoLeft ? leftHeight : rightHeight;
+    int shortHeight = intoLeft ? rightHeight : leftHeight;
+    AVLNode<Key, Value>* parent = nullptr;
+    AVLNode<Key, Value>* spine = top;
+    int spineHeight = topHeight;
+    while(spineHeight > shortHeight + 1){
+      spineHeight = childHeight(spine, spineHeight, !intoLeft);
+      parent = spine;
+      spine = intoLeft ? spine->getRight() : spine->getLeft();
+    }
 
+    AVLNode<Key, Value>* shortTree = intoLeft ? right : left;
+    k->setParent(parent);
+    k->setLeft(intoLeft ? spine : shortTree);
+    k->setRight(intoLeft ? shortTree : spine);
+    if(spine != nullptr){
+      spine->setParent(k);
+    }
+    if(shortTree != nullptr){
+      shortTree->setParent(k);
+    }
+    k->setBalance((int8_t)(intoLeft ? spineHeight - shortHeight : shortHeight - spineHeight));
+    if(intoLeft){
+      parent->setRight(k);
+    }
+    else{
+      parent->setLeft(k);
+    }
 
+    int8_t topBalance = top->getBalance();
+    this->root_ = top;
+    fixAugment(k);
+    augmentPath(parent);
+    balanceTree(parent, intoLeft ? -1 : 1);
+
+    // only a retrace that reaches the old root without rotating there
+    // and tips it off level makes the tree taller
+    bool grew = (this->root_ == top && topBalance == 0 && top->getBalance() != 0);
+    height = grew ? topHeight + 1 : topHeight;
+    return static_cast<AVLNode<Key, Value>*>(this->root_);
+}
 
-/*
-template<class Key, class Value>
-void AVLTree<Key, Value>:: balanceTreeForInsert(AVLNode<Key, Value>* tempParent, int rol){ // rol stores the number that node added to the tree like +1 is added as right kid or -1 is left 
+// helper function to balance the tree after an insertion: 
+// rol is +1 if the subtree of tempParent that grew is its left one, -1 if it is the right one
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::balanceTree(AVLNode<Key, Value>* tempParent, int rol){
     
   //start at tempParent and walk upward to balance along that path
   AVLNode<Key, Value>* treeIterator = tempParent; // start at tempParent to iterate the tree 
 
-  // base case: 
-  if(treeIterator == nullptr) { //  || tempParent->getBalance() == 0) {
-    return; // temp is the root so its all good 
-  }
-
-  // 1. find balance factor 
-  treeIterator->updateBalance(rol); // set the balance of the iterator!
-  int8_t balanceFactor = treeIterator->getBalance(); 
+  while(treeIterator != nullptr){
 
-  // if tree IS balanced
-  if(balanceFactor == 0){
-    return; // done !
-  }
-  // if tree is NOT balanced 
-  if(balanceFactor < -1){ // heavy on right kids 
+    // 1. find balance factor 
+    treeIterator->updateBalance(rol); // set the balance of the iterator!
+    int8_t balanceFactor = treeIterator->getBalance(); 
 
-    AVLNode<Key, Value>* rightKid = treeIterator->getRight(); // get the right kid
-    
-    if(rightKid != nullptr && rightKid->getBalance() > 0){
-      // case for RL 
-      // rightRotate(rightKid, treeIterator);
-      rightRotate(nullptr, rightKid);
+    // if subtree height did not change we are done 
+    if(balanceFactor == 0){
+      return; // done !
     }
-    // else {
-      // case for RR 
-      leftRotate(nullptr, treeIterator);
+    // if tree is NOT balanced, one single or double rotation restores the old height 
+    if(balanceFactor < -1){ // heavy on right kids 
+      AVLNode<Key, Value>* rightKid = treeIterator->getRight(); // get the right kid
+      if(rightKid->getBalance() > 0){
+        rightRotate(rightKid); // case for RL 
+      }
+      leftRotate(treeIterator); // case for RR 
       return; // the end so return 
-    // }
-  }
-  else if(balanceFactor > 1){ // heavy on left kids 
-    
-    AVLNode<Key, Value>* leftKid = treeIterator->getLeft(); // get the right kid
-    
-    if(leftKid != nullptr && leftKid->getBalance() < 0){
-      // case for LR 
-      // leftRotate(leftKid, treeIterator);
-      leftRotate(nullptr, leftKid);
     }
-    // else {
-      // case for LL 
-      rightRotate(nullptr, treeIterator);
+    if(balanceFactor > 1){ // heavy on left kids 
+      AVLNode<Key, Value>* leftKid = treeIterator->getLeft(); // get the left kid
+      if(leftKid->getBalance() < 0){
+        leftRotate(leftKid); // case for LR 
+      }
+      rightRotate(treeIterator); // case for LL 
       return; // the end so return 
-    // }
-  }
-
-  // get grand parent
-  AVLNode<Key, Value>* tempGrandParent = treeIterator->getParent(); // tempGrandParent stores the grandparent of temp 
-  
-  if(tempGrandParent == nullptr){
-    return; // we reached the root ! done !
-  }
+    }
 
-  // get the next rol 
-  int r; 
-  if(treeIterator == tempGrandParent->getLeft()){
-    r = 1; // then left kids heavier
-  }
-  else {
-    r = -1; // then right kids heavier 
+    // balance is +-1 so this subtree grew: move up the tree along the path to the root
+    AVLNode<Key, Value>* tempGrandParent = treeIterator->getParent();
+    if(tempGrandParent != nullptr){
+      rol = (treeIterator == tempGrandParent->getLeft()) ? 1 : -1;
+    }
+    treeIterator = tempGrandParent;
   }
-  
-  // recursive call: 
-  balanceTreeForInsert(tempGrandParent, r); // move up the tree along the path tyo the root
-
-  return; // balanceFactor is zero and good so return !
 }
 
+// helper function to balance the tree after a deletion: 
+// rol is -1 if the subtree of tempParent that shrank is its left one, +1 if it is the right one
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::balanceTreeForRemove(AVLNode<Key, Value>* tempParent, int rol){
 
-
-template<class Key, class Value>
-void AVLTree<Key, Value>:: balanceTreeForRemove(AVLNode<Key, Value>* tempParent, int rol){ // rol stores the number that node added to the tree like +1 is added as right kid or -1 is left 
-    
-  //start at tempParent and walk upward to balance along that path
   AVLNode<Key, Value>* treeIterator = tempParent; // start at tempParent to iterate the tree 
 
-  // base case: 
-  if(treeIterator == nullptr) { //  || tempParent->getBalance() == 0) {
-    return; // temp is the root so its all good 
-  }
-
-  // 1. find balance factor 
-  treeIterator->updateBalance(rol); // set the balance of the iterator!
-  int8_t balanceFactor = treeIterator->getBalance(); 
+  while(treeIterator != nullptr){
 
-  // if tree IS balanced
-  //if(balanceFactor == 0){
-  //  return; // done !
-  //}
-
-  if(balanceFactor == 1 || balanceFactor == -1){
-    return; // the subtree height didn't change !! so just retrunr
-  }
-
-  // if tree is NOT balanced 
-  if(balanceFactor < -1){ // heavy on right kids 
-
-    AVLNode<Key, Value>* rightKid = treeIterator->getRight(); // get the right kid
-    
-    // find balanceFactor for rightKid: 
-    int8_t balanceFactorOfRightKid;
-    if(rightKid != nullptr){
-      balanceFactorOfRightKid = rightKid->getBalance();
-    }
-    else{
-      balanceFactorOfRightKid = 0; // 
-    }
+    treeIterator->updateBalance(rol);
+    int8_t balanceFactor = treeIterator->getBalance(); 
 
-    if(rightKid != nullptr && balanceFactorOfRightKid > 0){
-      // case for RL 
-      // rightRotate(rightKid, treeIterator);
-      rightRotate(nullptr, rightKid);
+    if(balanceFactor == 1 || balanceFactor == -1){
+      return; // the subtree height didn't change !! so just return
     }
-    // else {
-      // case for RR 
-      leftRotate(nullptr, treeIterator);
 
-      if(balanceFactorOfRightKid != 0){
+    if(balanceFactor < -1){ // heavy on right kids 
+      AVLNode<Key, Value>* rightKid = treeIterator->getRight();
+      int8_t balanceFactorOfRightKid = rightKid->getBalance();
+      if(balanceFactorOfRightKid > 0){
+        rightRotate(rightKid); // case for RL 
+      }
+      leftRotate(treeIterator); // case for RR 
+      treeIterator = treeIterator->getParent(); // new root of this subtree 
+      if(balanceFactorOfRightKid == 0){
         return; // height of this subtree did not decrease 
       }
-    // }
-  }
-  else if(balanceFactor > 1){ // heavy on left kids 
-    
-    AVLNode<Key, Value>* leftKid = treeIterator->getLeft(); // get the right kid
-    
-    // find balanceFactor for leftKid: 
-    int8_t balanceFactorOfLeftKid;
-    if(leftKid != nullptr){
-      balanceFactorOfLeftKid = leftKid->getBalance();
     }
-    else{
-      balanceFactorOfLeftKid = 0; // 
+    else if(balanceFactor > 1){ // heavy on left kids 
+      AVLNode<Key, Value>* leftKid = treeIterator->getLeft();
+      int8_t balanceFactorOfLeftKid = leftKid->getBalance();
+      if(balanceFactorOfLeftKid < 0){
+        leftRotate(leftKid); // case for LR 
+      }
+      rightRotate(treeIterator); // case for LL 
+      treeIterator = treeIterator->getParent(); // new root of this subtree 
+      if(balanceFactorOfLeftKid == 0){
+        return; // height of this subtree did not decrease 
+      }
     }
 
-    if(leftKid != nullptr && leftKid->getBalance() < 0){
-      // case for LR 
-      // leftRotate(leftKid, treeIterator);
-      leftRotate(nullptr, leftKid);
+    // this subtree got shorter so keep going up the path to the root
+    AVLNode<Key, Value>* tempGrandParent = treeIterator->getParent();
+    if(tempGrandParent != nullptr){
+      rol = (treeIterator == tempGrandParent->getLeft()) ? -1 : 1;
     }
-      // else 
-      // case for LL 
-      rightRotate(nullptr, treeIterator);
-
-      if(balanceFactorOfLeftKid != 0){
-        return;
-      }
-      // return; // the end so return 
-    // }
-  }
-  // then balanceFactor will be good so continue on 
-
-  // get grand parent
-  AVLNode<Key, Value>* tempGrandParent = treeIterator->getParent(); // tempGrandParent stores the grandparent of temp 
-  
-  if(tempGrandParent == nullptr){
-    return; // we reached the root ! done !
-  }
-
-  // get the next rol 
-  int r; 
-  if(treeIterator == tempGrandParent->getLeft()){
-    r = -1; // then left kids heavier
+    treeIterator = tempGrandParent;
   }
-  else {
-    r = 1; // then right kids heavier 
-  }
-  
-  // recursive call: 
-  balanceTreeForRemove(tempGrandParent, r); // move up the tree along the path tyo the root
-
-  return; // balanceFactor is zero and good so return !
 }
 
-*/
-
-
-
 
 
-// helper function to rotate nodes right 
-template<class Key, class Value>
-void AVLTree<Key, Value>::rightRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Value>* tempParent){
-  
-  // follow x, y, z rotation 
-  AVLNode<Key, Value>* z = tempParent; // z is the parent 
+// helper function to rotate nodes right: z's left kid y takes z's place 
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::rightRotate(AVLNode<Key, Value>* z){
   
   // base case: 
-  if(tempParent == nullptr){
-    return; // temp is the root so all good ! 
+  if(z == nullptr){
+    return; // all good ! 
   }
 
   AVLNode<Key, Value>* y = z->getLeft(); // y is left kid 
@@ -496,7 +630,6 @@ void AVLTree<Key, Value>::rightRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Va
     return; // all good 
   }
 
-  // figure out LL, RR, LR, RL: 
   AVLNode<Key, Value>* zigzag = y->getRight(); // zig zag 
   AVLNode<Key, Value>* tempGrandParent = z->getParent();
 
@@ -520,37 +653,37 @@ void AVLTree<Key, Value>::rightRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Va
     tempGrandParent->setRight(y);
   }
 
-  // reset the balance: 
-  z->setBalance(0);
-  y->setBalance(0);
+  // update the balances (left height minus right height) from the old ones 
+  int8_t zBalance = z->getBalance();
+  int8_t yBalance = y->getBalance();
+  zBalance = zBalance - 1 - std::max<int8_t>(yBalance, 0);
+  yBalance = yBalance - 1 + std::min<int8_t>(zBalance, 0);
+  z->setBalance(zBalance);
+  y->setBalance(yBalance);
+  fixAugment(z); // z is now y's kid so it goes first
+  fixAugment(y);
 
   return;
 } 
 
 
 
+// helper function to rotate nodes left: z's right kid y takes z's place 
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::leftRotate(AVLNode<Key, Value>* z){
 
-
-// helper function to rotate nodes left 
-template<class Key, class Value>
-void AVLTree<Key, Value>::leftRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Value>* tempParent){
-
-  // follow x, y, z rotation 
-  AVLNode<Key, Value>* z = tempParent; // z is the parent 
-  
   // base case: 
-  if(tempParent == nullptr){
-    return; // temp is the root so all good ! 
+  if(z == nullptr){
+    return; // all good ! 
   }
 
-  AVLNode<Key, Value>* y = z->getRight(); // y is left kid 
+  AVLNode<Key, Value>* y = z->getRight(); // y is right kid 
 
   // base case: 
   if(y == nullptr){
     return; // all good 
   }
 
-  // figure out LL, RR, LR, RL: 
   AVLNode<Key, Value>* zagzig = y->getLeft(); // zig zag 
   AVLNode<Key, Value>* tempGrandParent = z->getParent();
 
@@ -574,171 +707,72 @@ void AVLTree<Key, Value>::leftRotate(AVLNode<Key, Value>* temp, AVLNode<Key, Val
     tempGrandParent->setRight(y);
   }
 
-  // reset the balance: 
-  z->setBalance(0);
-  y->setBalance(0);
+  // update the balances (left height minus right height) from the old ones 
+  int8_t zBalance = z->getBalance();
+  int8_t yBalance = y->getBalance();
+  zBalance = zBalance + 1 - std::min<int8_t>(yBalance, 0);
+  yBalance = yBalance + 1 + std::max<int8_t>(zBalance, 0);
+  z->setBalance(zBalance);
+  y->setBalance(yBalance);
+  fixAugment(z); // z is now y's kid so it goes first
+  fixAugment(y);
 
   return;
 }
 
 
 
-
-
-
 /*
  * Recall: The writeup specifies that if a node has 2 children you
  * should swap with the predecessor and then remove.
+ * remove() finds the node and hands it to this.
  */
-template<class Key, class Value>
-void AVLTree<Key, Value>:: remove(const Key& key)
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::removeNode(Node<Key, Value>* temp)
 {
-  // TODO
-
-  // case in which the tree is empty 
-  if(this->root_ == nullptr){
-    return; // just return 
-  }
-
-  Node<Key, Value>* temp = this->root_; // start temp at the root 
-  Node<Key, Value>* tempParent = nullptr; // so that we can remove nodes with kids 
-
-  // 1. walk the tree to find the value to remove --> traverse down 
-  while(temp != nullptr){ // while ptr is not at end 
-
-    if(key < temp->getKey()){
-      tempParent = temp; // update parent 
-      temp = temp->getLeft(); // key < so go left 
-    }
-    else if(key > temp->getKey()){
-      tempParent = temp; // update parent 
-      temp = temp->getRight(); // key < so go left 
-    }
-    else {
-      // else the key matches !! 
-      break; // and temp points to the node to remove 
-    }
-  }
-
-  if(temp == nullptr){
-    return; // key was not found :(
-  }
-
-  // 2. remove the node 
-  
-  // case if node to remove has zero kids: remove leaf 
-  if(temp->getLeft() == nullptr && temp->getRight() == nullptr){
-
-    // keep track of height: 
-    bool removedFromLeft = false; // flag for which side removed on 
-    bool removedFromRight = false; 
-    
-    // case if root is the node to delete 
-    if(tempParent == nullptr){
-      this->root_ = nullptr;
-    }
-    // case if left kid
-    else if(tempParent->getLeft() == temp){ // temp is left kid 
-      tempParent->setLeft(nullptr); 
-      removedFromLeft = true;
-    }
-    // case if right kid 
-    else if(tempParent->getRight() == temp){ // temp is right kid 
-      tempParent->setRight(nullptr); 
-      removedFromRight = true; 
-    }
-
-    // Rebalance !!! 
-    if(tempParent != nullptr){
-      AVLNode<Key, Value>* avlPtrParent = static_cast<AVLNode<Key, Value>*>(tempParent);
-      int rol = 0; // create rol for balanceTree 
-
-      if(removedFromLeft){
-        rol = -1; // right kids heavier 
-      }
-      if(removedFromRight){
-        rol = 1; // left kids heavier 
-      }
-
-      if(rol != 0){
-        balanceTree(avlPtrParent, rol);
-        // balanceTreeForRemove(avlPtrParent, rol);
-      }
-    }
-
-    delete temp; // delete 
-    return;
-  } 
 
   // A. case if nodeToRemove has 2 kids: swap the value with its predecessor -> remove from it's new location 
   if(temp->getLeft() != nullptr && temp->getRight() != nullptr) {
-    Node<Key, Value>* tempPredecessor = BinarySearchTree<Key, Value>::predecessor(temp); // to store the predecessor 
-
-    if(tempPredecessor == nullptr)
-      return;
-
+    Node<Key, Value>* tempPredecessor = BinarySearchTree<Key, Value, Compare>::predecessor(temp); // to store the predecessor 
     this->nodeSwap(static_cast<AVLNode<Key, Value>*>(tempPredecessor), static_cast<AVLNode<Key, Value>*>(temp));
-    tempParent = temp->getParent();
   }
 
-  // B. case if node to remove has one kid: connect parent and grandkid and delete temp 
-  Node<Key, Value>* tempKid = nullptr; // tempKid stores the kid of temp 
-
-  if(temp->getLeft() == nullptr && temp->getRight() != nullptr){ // if temp has a right kid 
-    tempKid = temp->getRight(); // rightKid stores the right kid
-  }
-  else if(temp->getLeft() != nullptr && temp->getRight() == nullptr){ // if temp has a left kid
-    tempKid = temp->getLeft(); // leftKid stores the right kid
-  }
-  else{
-    tempKid = nullptr; // no kids so leaf and return null
-  }
+  // B. now temp has at most one kid: connect parent and grandkid and delete temp 
+  Node<Key, Value>* tempParent = temp->getParent();
+  Node<Key, Value>* tempKid = (temp->getLeft() != nullptr) ? temp->getLeft() : temp->getRight();
  
   if(tempKid != nullptr){
     tempKid->setParent(tempParent); // connect the parent
   }
 
-  // reset the flags 
-  bool removedFromLeft = false; // flag for which side removed on 
-  bool removedFromRight = false;
-
-  if(tempParent == nullptr){ // the root is the node to deletee
+  int rol = 0; // which side of the parent got shorter 
+  if(tempParent == nullptr){ // the root is the node to delete
     this->root_ = tempKid; 
   }
   else if(tempParent->getLeft() == temp){ // temp is left kid 
     tempParent->setLeft(tempKid); // connect parent
-    removedFromLeft = true; 
+    rol = -1; // right kids heavier 
   }
   else { // temp is right kid 
     tempParent->setRight(tempKid); // connect parent
-    removedFromRight = true; 
+    rol = 1; // left kids heavier 
   }
 
   // Rebalance !!! 
   if(tempParent != nullptr){
-    AVLNode<Key, Value>* avlPtrParent = static_cast<AVLNode<Key, Value>*>(tempParent);
-    int rol = 0; // create rol for balanceTree 
-
-    if(removedFromLeft){
-      rol = -1; // right kids heavier 
-    }
-    if(removedFromRight){
-      rol = 1; // left kids heavier 
-    }
-
-    if(rol != 0){
-      balanceTree(avlPtrParent, rol);
-    }
+    // the predecessor that moved up sits on this path too
+    augmentPath(static_cast<AVLNode<Key, Value>*>(tempParent));
+    balanceTreeForRemove(static_cast<AVLNode<Key, Value>*>(tempParent), rol);
   }
 
-  delete temp; // delete  
+  this->destroyNode(temp); // delete  
   return;
 }
 
-template<class Key, class Value>
-void AVLTree<Key, Value>::nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2)
+template<class Key, class Value, class Compare>
+void AVLTree<Key, Value, Compare>::nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2)
 {
-    BinarySearchTree<Key, Value>::nodeSwap(n1, n2);
+    BinarySearchTree<Key, Value, Compare>::nodeSwap(n1, n2);
     int8_t tempB = n1->getBalance();
     n1->setBalance(n2->getBalance());
     n2->setBalance(tempB);
@@ -0,0 +1,1475 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+#include <thread>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "bst.h"
+#include "avlbst.h"
+#include "splaybst.h"
+#include "rbbst.h"
+#include "scapegoatbst.h"
+#include "lazyavlbst.h"
+#include "augmentedbst.h"
+#include "intervalbst.h"
+#include "multiavlbst.h"
+#include "fixedavlbst.h"
+#include "lrubst.h"
+#include "intrusivebst.h"
+#include "tracebst.h"
+#include "perfcounters.h"
+
+using namespace std;
+
+// Usage: ./bst-bench [workload] [n]
+// Runs every workload when none is named.
+
+/**
+* Counts comparator calls so the benchmark can report comparisons per lookup.
+*/
+static size_t comparisonCount = 0;
+
+struct CountingLess
+{
+    bool operator()(const string& a, const string& b) const
+    {
+        ++comparisonCount;
+        return a < b;
+    }
+};
+
+struct CountingThreeWay
+{
+    bool operator()(const string& a, const string& b) const
+    {
+        ++comparisonCount;
+        return a < b;
+    }
+    int compare(const string& a, const string& b) const
+    {
+        ++comparisonCount;
+        return a.compare(b);
+    }
+};
+
+/**
+* The hardware counters every timer snapshots. Opened on first use and
+* left running for the whole run.
+*/
+static PerfCounters& benchCounters()
+{
+    static PerfCounters counters;
+    return counters;
+}
+
+class BenchTimer
+{
+public:
+    BenchTimer() : counters_(benchCounters().read()), start_(chrono::steady_clock::now()) {}
+    double seconds() const
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - start_).count();
+    }
+    // Counter increments since the timer started
+    PerfCounters::Snapshot counted() const
+    {
+        PerfCounters::Snapshot now = benchCounters().read();
+        for(int e = 0; e < PerfCounters::EVENT_COUNT; ++e) {
+            now.values[e] -= counters_.values[e];
+        }
+        return now;
+    }
+private:
+    PerfCounters::Snapshot counters_;
+    chrono::steady_clock::time_point start_;
+};
+
+/**
+* Prints ns/op and, for each hardware counter that could be opened, its
+* count per op.
+*/
+static void report(const string& name, size_t ops, const BenchTimer& timer)
+{
+    double seconds = timer.seconds();
+    PerfCounters::Snapshot counted = timer.counted();
+    cout << left << setw(44) << name << right << setw(10) << fixed << setprecision(1)
+         << (seconds * 1e9 / ops) << " ns/op";
+    static const char* labels[PerfCounters::EVENT_COUNT] = { "ins", "L1d", "LLC", "br", "dTLB" };
+    for(int e = 0; e < PerfCounters::EVENT_COUNT; ++e) {
+        if(benchCounters().available((PerfCounters::Event)e)) {
+            cout << "  " << labels[e] << " " << setprecision(e == PerfCounters::INSTRUCTIONS ? 0 : 2)
+                 << (double)counted.values[e] / ops;
+        }
+    }
+    cout << endl;
+}
+
+// Keys share a long prefix, the way our session and composite keys do,
+// so every comparison has to scan past it.
+static vector<string> makeStringKeys(size_t n, unsigned seed)
+{
+    mt19937 rng(seed);
+    vector<string> keys;
+    keys.reserve(n);
+    for(size_t i = 0; i < n; ++i) {
+        keys.push_back("tenant/0042/session/" + to_string(rng()));
+    }
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    shuffle(keys.begin(), keys.end(), rng);
+    return keys;
+}
+
+static vector<int> makeIntKeys(size_t n, unsigned seed)
+{
+    vector<int> keys(n);
+    for(size_t i = 0; i < n; ++i) {
+        keys[i] = (int)i;
+    }
+    shuffle(keys.begin(), keys.end(), mt19937(seed));
+    return keys;
+}
+
+/**
+* Inserts every key then looks every key up, reporting each phase
+* separately. Works on our trees and std::map.
+*/
+template<typename Tree, typename Key>
+void runInsertFind(const string& label, Tree& tree, const vector<Key>& keys)
+{
+    BenchTimer insertTimer;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.insert(make_pair(keys[i], (int)i));
+    }
+    report(label + " insert", keys.size(), insertTimer);
+
+    size_t found = 0;
+    BenchTimer findTimer;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        if(tree.find(keys[i]) != tree.end()) {
+            ++found;
+        }
+    }
+    report(label + " find", keys.size(), findTimer);
+    if(found != keys.size()) {
+        cout << "  error: only found " << found << " of " << keys.size() << " keys" << endl;
+    }
+}
+
+template<typename Tree, typename Key>
+void removeAll(const string& label, Tree& tree, const vector<Key>& keys)
+{
+    BenchTimer removeTimer;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.remove(keys[i]);
+    }
+    report(label + " remove", keys.size(), removeTimer);
+}
+
+template<typename Tree>
+void countFindComparisons(const string& label, Tree& tree, const vector<string>& keys)
+{
+    comparisonCount = 0;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.find(keys[i]);
+    }
+    cout << left << setw(44) << (label + " comparisons/find") << right << setw(10)
+         << fixed << setprecision(1) << ((double)comparisonCount / keys.size()) << endl;
+}
+
+static void benchStrings(size_t n)
+{
+    cout << "-- string keys, n = " << n << endl;
+    vector<string> keys = makeStringKeys(n, 104);
+
+    {
+        AVLTree<string, int> tree;
+        runInsertFind("AVLTree<string> std::less", tree, keys);
+        removeAll("AVLTree<string> std::less", tree, keys);
+    }
+    {
+        AVLTree<string, int, ThreeWayStringCompare> tree;
+        runInsertFind("AVLTree<string> three-way", tree, keys);
+        removeAll("AVLTree<string> three-way", tree, keys);
+    }
+    {
+        map<string, int> tree;
+        runInsertFind("std::map<string>", tree, keys);
+    }
+    {
+        AVLTree<string, int, CountingLess> lessTree;
+        AVLTree<string, int, CountingThreeWay> threeWayTree;
+        for(size_t i = 0; i < keys.size(); ++i) {
+            lessTree.insert(make_pair(keys[i], (int)i));
+            threeWayTree.insert(make_pair(keys[i], (int)i));
+        }
+        countFindComparisons("AVLTree<string> std::less", lessTree, keys);
+        countFindComparisons("AVLTree<string> three-way", threeWayTree, keys);
+    }
+}
+
+static void benchInts(size_t n)
+{
+    cout << "-- int keys, n = " << n << endl;
+    vector<int> keys = makeIntKeys(n, 104);
+    {
+        AVLTree<int, int> tree;
+        runInsertFind("AVLTree<int>", tree, keys);
+        removeAll("AVLTree<int>", tree, keys);
+    }
+    {
+        map<int, int> tree;
+        runInsertFind("std::map<int>", tree, keys);
+    }
+}
+
+// Draws count indices in [0, n) where index i has weight 1/(i+1)^skew.
+static vector<size_t> makeZipfQueries(size_t n, size_t count, double skew, unsigned seed)
+{
+    vector<double> cdf(n);
+    double total = 0;
+    for(size_t i = 0; i < n; ++i) {
+        total += 1.0 / pow((double)(i + 1), skew);
+        cdf[i] = total;
+    }
+    mt19937 rng(seed);
+    uniform_real_distribution<double> uniform(0, total);
+    vector<size_t> queries(count);
+    for(size_t i = 0; i < count; ++i) {
+        queries[i] = lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        if(queries[i] >= n) {
+            queries[i] = n - 1;
+        }
+    }
+    return queries;
+}
+
+template<typename Tree>
+void runQueries(const string& label, Tree& tree, const vector<int>& keys, const vector<size_t>& queries)
+{
+    size_t found = 0;
+    BenchTimer timer;
+    for(size_t i = 0; i < queries.size(); ++i) {
+        if(tree.find(keys[queries[i]]) != tree.end()) {
+            ++found;
+        }
+    }
+    report(label, queries.size(), timer);
+    if(found != queries.size()) {
+        cout << "  error: only found " << found << " of " << queries.size() << " keys" << endl;
+    }
+}
+
+// Hot keys are spread over the key space (keys is shuffled) so the
+// skew is in access frequency only, not in key locality.
+static void benchSkewed(size_t n)
+{
+    cout << "-- skewed lookups, n = " << n << endl;
+    vector<int> keys = makeIntKeys(n, 104);
+    AVLTree<int, int> avl;
+    SplayTree<int, int> splay;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        avl.insert(make_pair(keys[i], (int)i));
+        splay.insert(make_pair(keys[i], (int)i));
+    }
+
+    const double skews[] = { 0.0, 0.8, 1.2 };
+    for(size_t i = 0; i < sizeof(skews) / sizeof(skews[0]); ++i) {
+        vector<size_t> queries = makeZipfQueries(n, 4 * n, skews[i], 7);
+        ostringstream name;
+        name << "zipf s=" << setprecision(1) << fixed << skews[i];
+        runQueries("AVLTree find " + name.str(), avl, keys, queries);
+        runQueries("SplayTree find " + name.str(), splay, keys, queries);
+    }
+}
+
+static void reportPercentiles(const string& name, vector<double>& latencies)
+{
+    sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    cout << left << setw(44) << name << right << fixed << setprecision(0)
+         << " p50 " << setw(6) << latencies[n / 2]
+         << " p99 " << setw(6) << latencies[n * 99 / 100]
+         << " p99.9 " << setw(7) << latencies[n * 999 / 1000]
+         << " max " << setw(8) << latencies[n - 1] << " ns" << endl;
+}
+
+/**
+* Prefills the tree, then runs a mix of inserts of fresh keys and
+* removes of random live keys. removeShare is the fraction of removes.
+* Every remove is timed on its own so the tail shows up.
+*/
+template<typename Tree>
+void runChurn(const string& label, size_t n, double removeShare)
+{
+    mt19937 rng(29);
+    uniform_real_distribution<double> coin(0, 1);
+    vector<int> live;
+    live.reserve(2 * n);
+    // multiplying by an odd constant permutes 30-bit values, so keys stay
+    // unique while new ones land all over the existing key range
+    unsigned nextKey = 0;
+    const unsigned keyMask = (1u << 30) - 1;
+    Tree tree;
+    for(size_t i = 0; i < n; ++i) {
+        live.push_back((int)((nextKey++ * 2654435761u) & keyMask));
+        tree.insert(make_pair(live.back(), 0));
+    }
+
+    vector<double> removeLatencies;
+    removeLatencies.reserve(4 * n);
+    BenchTimer timer;
+    for(size_t op = 0; op < 4 * n; ++op) {
+        if(coin(rng) < removeShare && !live.empty()) {
+            size_t victim = rng() % live.size();
+            int key = live[victim];
+            live[victim] = live.back();
+            live.pop_back();
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            tree.remove(key);
+            removeLatencies.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+        }
+        else {
+            live.push_back((int)((nextKey++ * 2654435761u) & keyMask));
+            tree.insert(make_pair(live.back(), 0));
+        }
+    }
+    report(label + " mixed op", 4 * n, timer);
+    reportPercentiles(label + " remove", removeLatencies);
+}
+
+static void benchChurn(size_t n)
+{
+    const double shares[] = { 0.5, 0.7 };
+    for(size_t i = 0; i < sizeof(shares) / sizeof(shares[0]); ++i) {
+        cout << "-- insert/remove churn, n = " << n << ", " << (int)(shares[i] * 100) << "% removes" << endl;
+        runChurn<AVLTree<int, int> >("AVLTree", n, shares[i]);
+        runChurn<RedBlackTree<int, int> >("RedBlackTree", n, shares[i]);
+    }
+}
+
+/**
+* Builds each engine from the same shuffled keys, then times repeated
+* uniform lookups. Node sizes are printed since they drive cache use.
+*/
+static void benchReadMostly(size_t n)
+{
+    cout << "-- read-mostly, n = " << n << endl;
+    cout << "node bytes: Node " << sizeof(Node<int, int>) << ", AVLNode " << sizeof(AVLNode<int, int>)
+         << ", RBNode " << sizeof(RBNode<int, int>) << endl;
+    vector<int> keys = makeIntKeys(n, 104);
+    vector<size_t> queries = makeZipfQueries(n, 4 * n, 0.0, 11);
+    {
+        AVLTree<int, int> tree;
+        runInsertFind("AVLTree", tree, keys);
+        runQueries("AVLTree find x4", tree, keys, queries);
+    }
+    {
+        RedBlackTree<int, int> tree;
+        runInsertFind("RedBlackTree", tree, keys);
+        runQueries("RedBlackTree find x4", tree, keys, queries);
+    }
+    {
+        ScapegoatTree<int, int> tree;
+        runInsertFind("ScapegoatTree", tree, keys);
+        runQueries("ScapegoatTree find x4", tree, keys, queries);
+    }
+}
+
+// Only lazy trees have anything to purge
+template<typename Tree>
+void purgeLazy(Tree&)
+{
+}
+
+template<typename Key, typename Value, typename Compare>
+void purgeLazy(LazyAVLTree<Key, Value, Compare>& tree)
+{
+    tree.purge();
+}
+
+/**
+* Builds the tree, removes half the keys in one burst with every remove
+* timed on its own, then times lookups on what is left. Lazy trees run
+* the burst with automatic purging off and one explicit purge after it,
+* and with the default threshold.
+*/
+template<typename Tree>
+void runDeleteBurst(const string& label, Tree& tree, const vector<int>& keys, bool purgeAfter)
+{
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.insert(make_pair(keys[i], (int)i));
+    }
+    vector<int> victims(keys.begin(), keys.begin() + keys.size() / 2);
+    shuffle(victims.begin(), victims.end(), mt19937(41));
+
+    vector<double> removeLatencies;
+    removeLatencies.reserve(victims.size());
+    BenchTimer timer;
+    for(size_t i = 0; i < victims.size(); ++i) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        tree.remove(victims[i]);
+        removeLatencies.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+    }
+    report(label + " remove", victims.size(), timer);
+    reportPercentiles(label + " remove", removeLatencies);
+
+    if(purgeAfter) {
+        BenchTimer purgeTimer;
+        purgeLazy(tree);
+        report(label + " purge", victims.size(), purgeTimer);
+    }
+
+    size_t found = 0;
+    BenchTimer findTimer;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        found += tree.count(keys[i]);
+    }
+    report(label + " find", keys.size(), findTimer);
+    if(found != keys.size() - victims.size()) {
+        cout << "  error: found " << found << " of " << keys.size() - victims.size() << " keys" << endl;
+    }
+}
+
+static void benchDeletes(size_t n)
+{
+    cout << "-- delete burst, n = " << n << ", half removed" << endl;
+    vector<int> keys = makeIntKeys(n, 53);
+    {
+        AVLTree<int, int> tree;
+        runDeleteBurst("AVLTree", tree, keys, false);
+    }
+    {
+        LazyAVLTree<int, int> tree;
+        runDeleteBurst("LazyAVLTree auto purge", tree, keys, false);
+    }
+    {
+        LazyAVLTree<int, int> tree(1.0);
+        runDeleteBurst("LazyAVLTree one purge", tree, keys, true);
+    }
+}
+
+/**
+* Compares rebuilding a tree by re-inserting every item against the
+* structural copy constructor, and times moves for scale.
+*/
+static void benchCopy(size_t n)
+{
+    cout << "-- copy, n = " << n << endl;
+    vector<int> keys = makeIntKeys(n, 77);
+    AVLTree<int, int> source;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        source.insert(make_pair(keys[i], (int)i));
+    }
+
+    BenchTimer rebuildTimer;
+    AVLTree<int, int> rebuilt;
+    for(AVLTree<int, int>::iterator it = source.begin(); it != source.end(); ++it) {
+        rebuilt.insert(*it);
+    }
+    report("AVLTree re-insert copy", n, rebuildTimer);
+
+    BenchTimer cloneTimer;
+    AVLTree<int, int> cloned(source);
+    report("AVLTree copy constructor", n, cloneTimer);
+
+    const size_t moves = 1000000;
+    BenchTimer moveTimer;
+    for(size_t i = 0; i < moves; ++i) {
+        AVLTree<int, int> temp(std::move(cloned));
+        cloned = std::move(temp);
+    }
+    report("AVLTree move construct + assign", moves, moveTimer);
+    if(!cloned.contains(keys[0]) || !rebuilt.contains(keys[0])) {
+        cout << "  error: copy lost keys" << endl;
+    }
+}
+
+/**
+* Sums every value with the iterator, then with parallelReduce on 1, 2,
+* 4, ... threads up to the hardware thread count.
+*/
+static void benchParallel(size_t n)
+{
+    unsigned hardware = thread::hardware_concurrency();
+    if(hardware == 0) {
+        hardware = 1;
+    }
+    cout << "-- parallel scan, n = " << n << ", " << hardware << " hardware threads" << endl;
+    vector<int> keys = makeIntKeys(n, 61);
+    AVLTree<int, int> tree;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.insert(make_pair(keys[i], (int)(i & 1023)));
+    }
+
+    const int passes = 10;
+    long long expected = 0;
+    BenchTimer iterTimer;
+    for(int pass = 0; pass < passes; ++pass) {
+        for(AVLTree<int, int>::iterator it = tree.begin(); it != tree.end(); ++it) {
+            expected += it->second;
+        }
+    }
+    double serial = iterTimer.seconds();
+    report("AVLTree iterator sum", passes * n, iterTimer);
+
+    for(unsigned threads = 1; threads <= hardware; threads *= 2) {
+        long long total = 0;
+        BenchTimer timer;
+        for(int pass = 0; pass < passes; ++pass) {
+            total += tree.parallelReduce(0LL,
+                [](const pair<const int, int>& item) { return (long long)item.second; },
+                [](long long a, long long b) { return a + b; },
+                threads);
+        }
+        double seconds = timer.seconds();
+        ostringstream name;
+        name << "AVLTree parallelReduce sum, " << threads << " threads";
+        report(name.str(), passes * n, timer);
+        cout << "  speedup over iterator " << setprecision(2) << fixed << serial / seconds << "x" << endl;
+        if(total != expected) {
+            cout << "  error: sum " << total << " != " << expected << endl;
+        }
+    }
+}
+
+/**
+* Range sums over windows of about 1% of the keys: a lower_bound scan on
+* AVLTree against AugmentedAVLTree::aggregate(). Inserts are timed too,
+* since keeping the sums current costs something.
+*/
+static void benchAggregate(size_t n)
+{
+    cout << "-- range aggregate, n = " << n << endl;
+    vector<int> keys = makeIntKeys(n, 83);
+    AVLTree<int, int> plain;
+    AugmentedAVLTree<int, int, SumMonoid<int, long long> > augmented;
+    runInsertFind("AVLTree", plain, keys);
+    runInsertFind("AugmentedAVLTree<Sum>", augmented, keys);
+
+    // makeIntKeys draws from the whole int range, so sort to pick windows
+    vector<int> sorted(keys);
+    sort(sorted.begin(), sorted.end());
+    size_t width = max<size_t>(n / 100, 1);
+    mt19937 rng(5);
+    vector<pair<int, int> > ranges;
+    for(size_t i = 0; i < 10000; ++i) {
+        size_t start = rng() % (n - width);
+        ranges.push_back(make_pair(sorted[start], sorted[start + width]));
+    }
+
+    long long scanTotal = 0;
+    BenchTimer scanTimer;
+    for(size_t i = 0; i < ranges.size(); ++i) {
+        for(AVLTree<int, int>::iterator it = plain.lower_bound(ranges[i].first);
+            it != plain.end() && it->first < ranges[i].second; ++it) {
+            scanTotal += it->second;
+        }
+    }
+    report("AVLTree lower_bound scan sum", ranges.size(), scanTimer);
+
+    long long aggregateTotal = 0;
+    BenchTimer aggregateTimer;
+    for(size_t i = 0; i < ranges.size(); ++i) {
+        aggregateTotal += augmented.aggregate(ranges[i].first, ranges[i].second);
+    }
+    report("AugmentedAVLTree aggregate sum", ranges.size(), aggregateTimer);
+    if(scanTotal != aggregateTotal) {
+        cout << "  error: sums differ " << scanTotal << " " << aggregateTotal << endl;
+    }
+}
+
+/**
+* Stabbing queries over n short reservations. The baseline keeps the
+* same intervals in an AVLTree keyed by (start, end) and has to scan
+* every interval that starts at or before the point.
+*/
+static void benchIntervals(size_t n)
+{
+    cout << "-- interval stabbing, n = " << n << endl;
+    mt19937 rng(71);
+    const int span = (int)min<size_t>(n * 10, 1u << 30);
+    IntervalTree<int, int> intervals;
+    AVLTree<pair<int, int>, int> byStart;
+    BenchTimer insertTimer;
+    for(size_t i = 0; i < n; ++i) {
+        int start = (int)(rng() % span);
+        intervals.insert(start, start + 1 + (int)(rng() % 100), (int)i);
+    }
+    report("IntervalTree insert", n, insertTimer);
+    for(IntervalTree<int, int>::iterator it = intervals.begin(); it != intervals.end(); ++it) {
+        byStart.insert(*it);
+    }
+
+    vector<int> points;
+    for(size_t i = 0; i < 100000; ++i) {
+        points.push_back((int)(rng() % span));
+    }
+
+    size_t treeHits = 0;
+    BenchTimer treeTimer;
+    for(size_t i = 0; i < points.size(); ++i) {
+        intervals.forEachStabbing(points[i], [&treeHits](pair<const pair<int, int>, int>&) { ++treeHits; });
+    }
+    report("IntervalTree stab", points.size(), treeTimer);
+
+    // the scan is O(n) per query, so only run a few
+    const size_t scanQueries = 200;
+    size_t scanHits = 0;
+    size_t sampleHits = 0;
+    BenchTimer scanTimer;
+    for(size_t i = 0; i < scanQueries; ++i) {
+        for(AVLTree<pair<int, int>, int>::iterator it = byStart.begin(); it != byStart.end() && it->first.first <= points[i]; ++it) {
+            if(points[i] < it->first.second) {
+                ++scanHits;
+            }
+        }
+    }
+    report("AVLTree scan from begin()", scanQueries, scanTimer);
+    for(size_t i = 0; i < scanQueries; ++i) {
+        sampleHits += intervals.stab(points[i]).size();
+    }
+    if(scanHits != sampleHits) {
+        cout << "  error: hits differ " << scanHits << " " << sampleHits << endl;
+    }
+    cout << "  " << setprecision(2) << fixed << (double)treeHits / points.size() << " hits per query" << endl;
+}
+
+/**
+* n items over n / 8 distinct keys: the old AVLTree<int, vector<int> >
+* emulation against MultiAVLTree and std::multimap, then a pass that
+* reads every item through equal_range.
+*/
+static void benchMultimap(size_t n)
+{
+    cout << "-- multimap, n = " << n << ", about 8 items per key" << endl;
+    mt19937 rng(19);
+    size_t distinct = max<size_t>(n / 8, 1);
+    vector<int> keys;
+    for(size_t i = 0; i < n; ++i) {
+        keys.push_back((int)(rng() % distinct));
+    }
+
+    long long vectorSum = 0;
+    {
+        AVLTree<int, vector<int> > tree;
+        BenchTimer timer;
+        for(size_t i = 0; i < keys.size(); ++i) {
+            AVLTree<int, vector<int> >::iterator it = tree.find(keys[i]);
+            if(it == tree.end()) {
+                tree.insert(make_pair(keys[i], vector<int>(1, (int)i)));
+            }
+            else {
+                it->second.push_back((int)i);
+            }
+        }
+        report("AVLTree<int, vector> insert", n, timer);
+        BenchTimer readTimer;
+        for(size_t k = 0; k < distinct; ++k) {
+            AVLTree<int, vector<int> >::iterator it = tree.find((int)k);
+            if(it != tree.end()) {
+                for(size_t j = 0; j < it->second.size(); ++j) {
+                    vectorSum += it->second[j];
+                }
+            }
+        }
+        report("AVLTree<int, vector> read all", n, readTimer);
+    }
+
+    long long multiSum = 0;
+    {
+        MultiAVLTree<int, int> tree;
+        BenchTimer timer;
+        for(size_t i = 0; i < keys.size(); ++i) {
+            tree.insert(make_pair(keys[i], (int)i));
+        }
+        report("MultiAVLTree insert", n, timer);
+        BenchTimer readTimer;
+        for(size_t k = 0; k < distinct; ++k) {
+            pair<MultiAVLTree<int, int>::iterator, MultiAVLTree<int, int>::iterator> range = tree.equal_range((int)k);
+            for(MultiAVLTree<int, int>::iterator it = range.first; it != range.second; ++it) {
+                multiSum += it->second;
+            }
+        }
+        report("MultiAVLTree read all", n, readTimer);
+    }
+
+    {
+        multimap<int, int> reference;
+        BenchTimer timer;
+        for(size_t i = 0; i < keys.size(); ++i) {
+            reference.insert(make_pair(keys[i], (int)i));
+        }
+        report("std::multimap insert", n, timer);
+    }
+
+    if(vectorSum != multiSum) {
+        cout << "  error: sums differ " << vectorSum << " " << multiSum << endl;
+    }
+}
+
+/**
+* A 4096-entry lookup table, the size of our config tables, held in a
+* FixedAVLTree and in an AVLTree, then n random lookups against each.
+* The fixed tree's slots sit in one array, so nearby nodes share lines.
+*/
+static void benchFixed(size_t n)
+{
+    const size_t tableSize = 4096;
+    cout << "-- fixed capacity, " << tableSize << " keys, n = " << n << " lookups" << endl;
+    vector<int> keys = makeIntKeys(tableSize, 23);
+    static FixedAVLTree<int, int, 4096> fixedTable;
+    fixedTable.clear();
+    AVLTree<int, int> heapTable;
+    BenchTimer fixedInsertTimer;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        fixedTable.insert(make_pair(keys[i], (int)i));
+    }
+    report("FixedAVLTree insert", keys.size(), fixedInsertTimer);
+    BenchTimer heapInsertTimer;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        heapTable.insert(make_pair(keys[i], (int)i));
+    }
+    report("AVLTree insert", keys.size(), heapInsertTimer);
+
+    mt19937 rng(24);
+    vector<int> queries;
+    for(size_t i = 0; i < n; ++i) {
+        queries.push_back((int)(rng() % (2 * tableSize)));
+    }
+    size_t fixedHits = 0;
+    BenchTimer fixedTimer;
+    for(size_t i = 0; i < queries.size(); ++i) {
+        fixedHits += fixedTable.count(queries[i]);
+    }
+    report("FixedAVLTree find", queries.size(), fixedTimer);
+    size_t heapHits = 0;
+    BenchTimer heapTimer;
+    for(size_t i = 0; i < queries.size(); ++i) {
+        heapHits += heapTable.count(queries[i]);
+    }
+    report("AVLTree find", queries.size(), heapTimer);
+
+    if(fixedHits != heapHits) {
+        cout << "  error: hits differ " << fixedHits << " " << heapHits << endl;
+    }
+}
+
+/**
+* Drops runs of 1000 adjacent keys from an AVLTree of n keys, once by
+* removing each key and once with erase(first, last).
+*/
+static void benchEraseRange(size_t n)
+{
+    const size_t run = 1000;
+    cout << "-- range erase, n = " << n << ", runs of " << run << endl;
+    vector<int> keys = makeIntKeys(n, 25);
+    mt19937 rng(26);
+    vector<int> starts;
+    for(size_t i = 0; i + run <= n && starts.size() < n / (4 * run); i += 4 * run) {
+        starts.push_back((int)(i + rng() % (3 * run)));
+    }
+    if(starts.empty()) {
+        cout << "  n is too small" << endl;
+        return;
+    }
+
+    AVLTree<int, int> byKey;
+    AVLTree<int, int> byRange;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        byKey.insert(make_pair(keys[i], (int)i));
+        byRange.insert(make_pair(keys[i], (int)i));
+    }
+
+    BenchTimer keyTimer;
+    for(size_t i = 0; i < starts.size(); ++i) {
+        for(int k = starts[i]; k < starts[i] + (int)run; ++k) {
+            byKey.remove(k);
+        }
+    }
+    report("AVLTree remove per key", starts.size() * run, keyTimer);
+
+    BenchTimer rangeTimer;
+    for(size_t i = 0; i < starts.size(); ++i) {
+        byRange.erase(byRange.lower_bound(starts[i]), byRange.lower_bound(starts[i] + (int)run));
+    }
+    report("AVLTree erase(first, last)", starts.size() * run, rangeTimer);
+
+    AVLTree<int, int>::iterator a = byKey.begin();
+    AVLTree<int, int>::iterator b = byRange.begin();
+    for(; a != byKey.end() && b != byRange.end(); ++a, ++b) {
+        if(a->first != b->first) {
+            break;
+        }
+    }
+    if(a != byKey.end() || b != byRange.end()) {
+        cout << "  error: trees differ" << endl;
+    }
+}
+
+/**
+* A cache of n / 4 entries in front of n keys, read with zipf s=0.8
+* requests and filled on a miss: the AVLTree + std::list +
+* std::unordered_map arrangement against LRUTree.
+*/
+static void benchLRU(size_t n)
+{
+    size_t capacity = max<size_t>(n / 4, 1);
+    cout << "-- LRU cache, " << capacity << " of " << n << " keys, zipf s=0.8" << endl;
+    vector<int> keys = makeIntKeys(n, 27);
+    vector<size_t> queries = makeZipfQueries(n, 4 * n, 0.8, 28);
+
+    size_t separateHits = 0;
+    {
+        AVLTree<int, int> tree;
+        list<int> order;
+        unordered_map<int, list<int>::iterator> where;
+        BenchTimer timer;
+        for(size_t i = 0; i < queries.size(); ++i) {
+            int key = keys[queries[i]];
+            unordered_map<int, list<int>::iterator>::iterator hit = where.find(key);
+            if(hit != where.end()) {
+                order.splice(order.end(), order, hit->second);
+                separateHits += (tree.find(key) != tree.end());
+                continue;
+            }
+            tree.insert(make_pair(key, (int)i));
+            where[key] = order.insert(order.end(), key);
+            if(order.size() > capacity) {
+                tree.remove(order.front());
+                where.erase(order.front());
+                order.pop_front();
+            }
+        }
+        report("AVLTree + list + unordered_map", queries.size(), timer);
+    }
+
+    size_t lruHits = 0;
+    {
+        LRUTree<int, int> cache(capacity);
+        BenchTimer timer;
+        for(size_t i = 0; i < queries.size(); ++i) {
+            int key = keys[queries[i]];
+            if(cache.find(key) != cache.end()) {
+                ++lruHits;
+                continue;
+            }
+            cache.insert(make_pair(key, (int)i));
+        }
+        report("LRUTree", queries.size(), timer);
+        cout << "  " << cache.bytes() / max<size_t>(cache.size(), 1) << " bytes per LRUTree entry, "
+             << setprecision(1) << fixed << 100.0 * lruHits / queries.size() << "% hits" << endl;
+    }
+
+    if(separateHits != lruHits) {
+        cout << "  error: hits differ " << separateHits << " " << lruHits << endl;
+    }
+}
+
+// A pooled record the size of our session objects.
+struct PooledRecord : public IntrusiveAVLHook<PooledRecord>
+{
+    int id;
+    char payload[56];
+};
+
+struct PooledRecordId
+{
+    const int& operator()(const PooledRecord& r) const { return r.id; }
+};
+
+/**
+* n records that already live in a pool, indexed by an AVLTree that
+* copies each into its own node, then by an IntrusiveAVLTree that links
+* the pooled records themselves.
+*/
+static void benchIntrusive(size_t n)
+{
+    cout << "-- intrusive, n = " << n << ", " << sizeof(PooledRecord) << "-byte records" << endl;
+    vector<int> keys = makeIntKeys(n, 29);
+    vector<PooledRecord> pool(n);
+    for(size_t i = 0; i < n; ++i) {
+        pool[i].id = keys[i];
+        memset(pool[i].payload, (int)(i & 0x7f), sizeof(pool[i].payload));
+    }
+    vector<int> queries = keys;
+    shuffle(queries.begin(), queries.end(), mt19937(30));
+
+    long long copiedSum = 0;
+    {
+        AVLTree<int, PooledRecord> tree;
+        BenchTimer insertTimer;
+        for(size_t i = 0; i < n; ++i) {
+            tree.insert(make_pair(pool[i].id, pool[i]));
+        }
+        report("AVLTree<int, record> insert", n, insertTimer);
+        BenchTimer findTimer;
+        for(size_t i = 0; i < queries.size(); ++i) {
+            copiedSum += tree.find(queries[i])->second.payload[0];
+        }
+        report("AVLTree<int, record> find", n, findTimer);
+        BenchTimer removeTimer;
+        for(size_t i = 0; i < queries.size(); ++i) {
+            tree.remove(queries[i]);
+        }
+        report("AVLTree<int, record> remove", n, removeTimer);
+    }
+
+    long long linkedSum = 0;
+    {
+        IntrusiveAVLTree<PooledRecord, int, PooledRecordId> tree;
+        BenchTimer insertTimer;
+        for(size_t i = 0; i < n; ++i) {
+            tree.insert(pool[i]);
+        }
+        report("IntrusiveAVLTree insert", n, insertTimer);
+        BenchTimer findTimer;
+        for(size_t i = 0; i < queries.size(); ++i) {
+            linkedSum += tree.find(queries[i])->payload[0];
+        }
+        report("IntrusiveAVLTree find", n, findTimer);
+        BenchTimer removeTimer;
+        for(size_t i = 0; i < queries.size(); ++i) {
+            tree.remove(queries[i]);
+        }
+        report("IntrusiveAVLTree remove", n, removeTimer);
+    }
+
+    if(copiedSum != linkedSum) {
+        cout << "  error: sums differ " << copiedSum << " " << linkedSum << endl;
+    }
+}
+
+template<typename Tree>
+size_t runTraceMix(Tree& tree, const vector<pair<TraceOp, int> >& ops)
+{
+    size_t found = 0;
+    for(size_t i = 0; i < ops.size(); ++i) {
+        switch(ops[i].first) {
+        case TRACE_INSERT:
+            tree.insert(make_pair(ops[i].second, (int)i));
+            break;
+        case TRACE_REMOVE:
+            tree.remove(ops[i].second);
+            break;
+        case TRACE_FIND:
+            found += (tree.find(ops[i].second) != tree.end());
+            break;
+        case TRACE_ITERATE:
+            for(typename Tree::iterator it = tree.begin(); it != tree.end(); ++it) {
+                ++found;
+            }
+            break;
+        }
+    }
+    return found;
+}
+
+/**
+* A service-like mix (n inserts, then 4n ops of which 80% are skewed
+* finds, 10% inserts, 10% removes, plus two full scans) run on a plain
+* AVLTree and on a TracedTree recording to bst-bench.trace, which
+* ./bst-replay can then run against every engine.
+*/
+static void benchTrace(size_t n)
+{
+    cout << "-- trace, n = " << n << endl;
+    vector<int> keys = makeIntKeys(2 * n, 31);
+    vector<size_t> queries = makeZipfQueries(n, 4 * n, 0.8, 32);
+    vector<pair<TraceOp, int> > ops;
+    for(size_t i = 0; i < n; ++i) {
+        ops.push_back(make_pair(TRACE_INSERT, keys[i]));
+    }
+    mt19937 rng(33);
+    size_t fresh = n;
+    for(size_t i = 0; i < queries.size(); ++i) {
+        unsigned roll = rng() % 10;
+        if(roll == 0 && fresh < keys.size()) {
+            ops.push_back(make_pair(TRACE_INSERT, keys[fresh++]));
+        }
+        else if(roll == 1) {
+            ops.push_back(make_pair(TRACE_REMOVE, keys[rng() % fresh]));
+        }
+        else {
+            ops.push_back(make_pair(TRACE_FIND, keys[queries[i]]));
+        }
+        if(i == queries.size() / 2 || i + 1 == queries.size()) {
+            ops.push_back(make_pair(TRACE_ITERATE, 0));
+        }
+    }
+
+    AVLTree<int, int> plain;
+    BenchTimer plainTimer;
+    size_t plainFound = runTraceMix(plain, ops);
+    report("AVLTree mix", ops.size(), plainTimer);
+
+    ofstream out("bst-bench.trace", ios::binary);
+    TracedTree<int, int> traced;
+    traced.startTrace(out);
+    BenchTimer tracedTimer;
+    size_t tracedFound = runTraceMix(traced, ops);
+    traced.stopTrace();
+    report("TracedTree mix, recording", ops.size(), tracedTimer);
+    double bytes = (double)out.tellp();
+    cout << "  bst-bench.trace: " << ops.size() << " ops, " << fixed << setprecision(2)
+         << bytes / ops.size() << " bytes/op" << endl;
+
+    if(plainFound != tracedFound) {
+        cout << "  error: results differ " << plainFound << " " << tracedFound << endl;
+    }
+}
+
+/**
+* This process's resident memory in bytes, or 0 where /proc/self/statm
+* isn't there to ask.
+*/
+static size_t residentBytes()
+{
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if(!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+template<typename Tree>
+static size_t estimatedBytes(const Tree& tree)
+{
+    return tree.memoryUsage().total();
+}
+
+template<typename Key, typename Value>
+static size_t estimatedBytes(const map<Key, Value>&)
+{
+    return 0;
+}
+
+/**
+* Builds the tree make() returns from keys and values in a child process,
+* so memory freed by earlier layouts can't be handed back out and hide
+* the cost, and prints how much resident memory it took per million
+* entries next to what memoryUsage() estimates.
+*/
+template<typename Make, typename Key, typename Value>
+static void measureFootprint(const string& label, Make make, const vector<Key>& keys, const vector<Value>& values)
+{
+    cout.flush();
+    pid_t child = fork();
+    if(child < 0) {
+        cout << "  error: fork failed for " << label << endl;
+        return;
+    }
+    if(child > 0) {
+        waitpid(child, NULL, 0);
+        return;
+    }
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    size_t before = residentBytes();
+    auto tree = make();
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.insert(make_pair(keys[i], values[i]));
+    }
+    size_t measured = residentBytes() - before;
+    size_t estimated = estimatedBytes(tree);
+
+    double perMillion = 1e6 / keys.size() / (1 << 20);
+    cout << left << setw(44) << label << right << fixed << setprecision(1)
+         << setw(8) << measured * perMillion << " MB/M measured";
+    if(estimated > 0) {
+        cout << setw(8) << estimated * perMillion << " MB/M estimated";
+    }
+    cout << setw(7) << (double)measured / keys.size() << " bytes/entry" << endl;
+    cout.flush();
+    _exit(0);
+}
+
+/**
+* Resident memory per million entries for each node layout, measured and
+* as memoryUsage() sees it. The last row has long string keys and values,
+* so most of its memory is theirs rather than the nodes'.
+*/
+static void benchMemory(size_t n)
+{
+    cout << "-- memory, n = " << n << endl;
+    if(residentBytes() == 0) {
+        cout << "  resident memory needs /proc/self/statm; skipping" << endl;
+        return;
+    }
+    vector<int> keys = makeIntKeys(n, 41);
+    vector<int> values(keys.begin(), keys.end());
+
+    measureFootprint("BinarySearchTree<int, int>", [] { return BinarySearchTree<int, int>(); }, keys, values);
+    measureFootprint("AVLTree<int, int>", [] { return AVLTree<int, int>(); }, keys, values);
+    measureFootprint("RedBlackTree<int, int>", [] { return RedBlackTree<int, int>(); }, keys, values);
+    measureFootprint("SplayTree<int, int>", [] { return SplayTree<int, int>(); }, keys, values);
+    measureFootprint("ScapegoatTree<int, int>", [] { return ScapegoatTree<int, int>(); }, keys, values);
+    measureFootprint("LazyAVLTree<int, int>", [] { return LazyAVLTree<int, int>(); }, keys, values);
+    measureFootprint("AugmentedAVLTree<int, int, Sum>",
+                     [] { return AugmentedAVLTree<int, int, SumMonoid<int, long long> >(); }, keys, values);
+    measureFootprint("LRUTree<int, int>", [n] { return LRUTree<int, int>(n); }, keys, values);
+    measureFootprint("MultiAVLTree<int, int>", [] { return MultiAVLTree<int, int>(); }, keys, values);
+    measureFootprint("std::map<int, int>", [] { return map<int, int>(); }, keys, values);
+
+    vector<string> stringKeys = makeStringKeys(n, 42);
+    vector<string> stringValues;
+    for(size_t i = 0; i < stringKeys.size(); ++i) {
+        stringValues.push_back("value too long to fit inside the string/" + to_string(i));
+    }
+    measureFootprint("AVLTree<string, string>", [] { return AVLTree<string, string>(); }, stringKeys, stringValues);
+}
+
+/**
+* Times random finds and a full scan over a tree.
+*/
+template<typename Tree>
+void runFindScan(const string& label, Tree& tree, const vector<int>& lookups)
+{
+    size_t found = 0;
+    BenchTimer findTimer;
+    for(size_t i = 0; i < lookups.size(); ++i) {
+        found += (tree.find(lookups[i]) != tree.end());
+    }
+    report(label + " find", lookups.size(), findTimer);
+
+    size_t items = 0;
+    long long sum = 0;
+    BenchTimer scanTimer;
+    for(typename Tree::iterator it = tree.begin(); it != tree.end(); ++it) {
+        sum += it->second;
+        ++items;
+    }
+    report(label + " scan", items, scanTimer);
+    if(found != lookups.size() || sum == -1) {
+        cout << "  error: only found " << found << " of " << lookups.size() << " keys" << endl;
+    }
+}
+
+/**
+* A long-lived AVLTree after heavy churn, so its nodes are scattered over
+* the heap, then the same tree after compact() has laid it out again:
+* once in one call, and once in 4096-node slices with churn in between.
+*/
+static void benchCompact(size_t n)
+{
+    cout << "-- compact, n = " << n << endl;
+    vector<int> keys = makeIntKeys(2 * n, 51);
+    AVLTree<int, int> tree;
+    for(size_t i = 0; i < n; ++i) {
+        tree.insert(make_pair(keys[i], (int)i));
+    }
+    // swap keys in and out so freed nodes get reused all over the tree
+    mt19937 rng(52);
+    vector<int> present(keys.begin(), keys.begin() + n);
+    vector<int> absent(keys.begin() + n, keys.end());
+    for(size_t round = 0; round < 4 * n; ++round) {
+        size_t in = rng() % present.size();
+        size_t out = rng() % absent.size();
+        tree.remove(present[in]);
+        tree.insert(make_pair(absent[out], (int)round));
+        swap(present[in], absent[out]);
+    }
+    vector<int> lookups(n);
+    for(size_t i = 0; i < n; ++i) {
+        lookups[i] = present[rng() % present.size()];
+    }
+
+    runFindScan("AVLTree after churn", tree, lookups);
+    {
+        BenchTimer timer;
+        tree.compact();
+        report("AVLTree compact(), per node", n, timer);
+    }
+    runFindScan("AVLTree compacted", tree, lookups);
+
+    // incremental: slices between bursts of churn, timing the slices only
+    double sliceSeconds = 0;
+    size_t slices = 0;
+    bool done = false;
+    while(!done) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        done = tree.compact(4096);
+        sliceSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ++slices;
+        for(int i = 0; i < 256; ++i) {
+            size_t in = rng() % present.size();
+            size_t out = rng() % absent.size();
+            tree.remove(present[in]);
+            tree.insert(make_pair(absent[out], i));
+            swap(present[in], absent[out]);
+        }
+    }
+    cout << "  " << slices << " slices of 4096 nodes, " << fixed << setprecision(1)
+         << sliceSeconds * 1e6 / slices << " us per slice" << endl;
+    for(size_t i = 0; i < n; ++i) {
+        lookups[i] = present[rng() % present.size()];
+    }
+    runFindScan("AVLTree compacted in slices", tree, lookups);
+}
+
+/**
+* Loops that lean on the ends of the tree: a begin()/size()/back() check
+* per iteration, and a scheduler-style loop that pops the smallest item
+* while watching the largest.
+*/
+static void benchEnds(size_t n)
+{
+    cout << "-- ends, n = " << n << endl;
+    vector<int> keys = makeIntKeys(n, 53);
+    AVLTree<int, int> tree;
+    for(size_t i = 0; i < n; ++i) {
+        tree.insert(make_pair(keys[i], (int)i));
+    }
+
+    long long sum = 0;
+    {
+        BenchTimer timer;
+        for(size_t i = 0; i < n; ++i) {
+            sum += tree.begin()->first;
+        }
+        report("AVLTree begin()", n, timer);
+    }
+    {
+        BenchTimer timer;
+        for(size_t i = 0; i < n; ++i) {
+            sum += tree.back().first;
+        }
+        report("AVLTree back()", n, timer);
+    }
+    {
+        BenchTimer timer;
+        for(size_t i = 0; i < n; ++i) {
+            AVLTree<int, int>::iterator last = tree.end();
+            sum += (--last)->first;
+        }
+        report("AVLTree --end()", n, timer);
+    }
+    {
+        BenchTimer timer;
+        for(size_t i = 0; i < n; ++i) {
+            sum += tree.size();
+        }
+        report("AVLTree size()", n, timer);
+    }
+    {
+        BenchTimer timer;
+        size_t pops = 0;
+        while(!tree.empty()) {
+            sum += tree.back().second;
+            tree.erase(tree.begin());
+            ++pops;
+        }
+        report("AVLTree pop smallest, peek largest", pops, timer);
+    }
+    if(sum == -1) {
+        cout << "  error: impossible sum" << endl;
+    }
+}
+
+/**
+* The same AVLTree searched with and without the find cache in front,
+* from uniform to heavily skewed. The cache should win on the skewed
+* runs and cost next to nothing on the uniform one.
+*/
+static void benchFindCache(size_t n)
+{
+    cout << "-- find cache, n = " << n << endl;
+    vector<int> keys = makeIntKeys(n, 54);
+    AVLTree<int, int> tree;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.insert(make_pair(keys[i], (int)i));
+    }
+
+    const double skews[] = { 0.0, 0.8, 1.2 };
+    const size_t slots[] = { 1024, 16384 };
+    for(size_t i = 0; i < sizeof(skews) / sizeof(skews[0]); ++i) {
+        vector<size_t> queries = makeZipfQueries(n, 4 * n, skews[i], 55);
+        ostringstream name;
+        name << "zipf s=" << setprecision(1) << fixed << skews[i];
+        tree.disableFindCache();
+        runQueries("AVLTree find " + name.str(), tree, keys, queries);
+        for(size_t j = 0; j < sizeof(slots) / sizeof(slots[0]); ++j) {
+            tree.enableFindCache(slots[j]);
+            ostringstream label;
+            label << "  cached, " << slots[j] << " slots";
+            runQueries(label.str(), tree, keys, queries);
+            cout << "    hit rate " << setprecision(1) << fixed
+                 << 100 * tree.findCacheStats().hitRate() << "%" << endl;
+        }
+    }
+    tree.disableFindCache();
+}
+
+// Lookups arrive as views into a network buffer. Building a std::string
+// per query allocates (the keys are past the small-string limit); the
+// transparent overloads compare against the view directly.
+static void benchHeterogeneous(size_t n)
+{
+    cout << "-- heterogeneous lookup, n = " << n << endl;
+    vector<string> keys = makeStringKeys(n, 104);
+    string buffer;
+    vector<pair<size_t, size_t> > spans;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        spans.push_back(make_pair(buffer.size(), keys[i].size()));
+        buffer += keys[i];
+        buffer += '\0';
+    }
+
+    AVLTree<string, int, ThreeWayStringCompare> tree;
+    for(size_t i = 0; i < keys.size(); ++i) {
+        tree.insert(make_pair(keys[i], (int)i));
+    }
+
+    size_t found = 0;
+    BenchTimer copyTimer;
+    for(size_t i = 0; i < spans.size(); ++i) {
+        found += tree.count(string(buffer.data() + spans[i].first, spans[i].second));
+    }
+    report("AVLTree find(std::string temporary)", spans.size(), copyTimer);
+
+    BenchTimer viewTimer;
+    for(size_t i = 0; i < spans.size(); ++i) {
+        found += tree.count(string_view(buffer.data() + spans[i].first, spans[i].second));
+    }
+    report("AVLTree find(string_view)", spans.size(), viewTimer);
+
+    BenchTimer cstrTimer;
+    for(size_t i = 0; i < spans.size(); ++i) {
+        found += tree.count(buffer.data() + spans[i].first);
+    }
+    report("AVLTree find(const char*)", spans.size(), cstrTimer);
+
+    if(found != 3 * spans.size()) {
+        cout << "  error: only found " << found << " of " << 3 * spans.size() << " keys" << endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    string workload = (argc > 1) ? argv[1] : "all";
+    size_t n = (argc > 2) ? strtoul(argv[2], NULL, 10) : 200000;
+
+    if(!benchCounters().available()) {
+        cout << "hardware counters unavailable (" << benchCounters().why() << "); reporting time only" << endl;
+    }
+    else {
+        cout << "per-op hardware counters: ins instructions, L1d/LLC/dTLB read misses, br branch misses";
+        if(!benchCounters().why().empty()) {
+            cout << " (missing " << benchCounters().why() << ")";
+        }
+        cout << endl;
+    }
+
+    bool all = (workload == "all");
+    bool ran = false;
+    if(all || workload == "strings") {
+        benchStrings(n);
+        ran = true;
+    }
+    if(all || workload == "ints") {
+        benchInts(n);
+        ran = true;
+    }
+
+    if(all || workload == "skewed") {
+        benchSkewed(n);
+        ran = true;
+    }
+    if(all || workload == "churn") {
+        benchChurn(n);
+        ran = true;
+    }
+    if(all || workload == "readmostly") {
+        benchReadMostly(n);
+        ran = true;
+    }
+    if(all || workload == "heterogeneous") {
+        benchHeterogeneous(n);
+        ran = true;
+    }
+    if(all || workload == "deletes") {
+        benchDeletes(n);
+        ran = true;
+    }
+    if(all || workload == "copy") {
+        benchCopy(n);
+        ran = true;
+    }
+    if(all || workload == "parallel") {
+        benchParallel(n);
+        ran = true;
+    }
+    if(all || workload == "aggregate") {
+        benchAggregate(n);
+        ran = true;
+    }
+    if(all || workload == "intervals") {
+        benchIntervals(n);
+        ran = true;
+    }
+    if(all || workload == "multimap") {
+        benchMultimap(n);
+        ran = true;
+    }
+    if(all || workload == "fixed") {
+        benchFixed(n);
+        ran = true;
+    }
+    if(all || workload == "erase") {
+        benchEraseRange(n);
+        ran = true;
+    }
+    if(all || workload == "lru") {
+        benchLRU(n);
+        ran = true;
+    }
+    if(all || workload == "trace") {
+        benchTrace(n);
+        ran = true;
+    }
+    if(all || workload == "intrusive") {
+        benchIntrusive(n);
+        ran = true;
+    }
+    if(all || workload == "memory") {
+        benchMemory(n);
+        ran = true;
+    }
+    if(all || workload == "compact") {
+        benchCompact(n);
+        ran = true;
+    }
+    if(all || workload == "ends") {
+        benchEnds(n);
+        ran = true;
+    }
+    if(all || workload == "findcache") {
+        benchFindCache(n);
+        ran = true;
+    }
+
+    if(!ran) {
+        cerr << "unknown workload: " << workload << endl;
+        cerr << "workloads: strings ints skewed churn readmostly heterogeneous deletes copy parallel aggregate intervals multimap fixed erase lru intrusive trace memory compact ends findcache" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include "bst.h"
+#include "avlbst.h"
+#include "splaybst.h"
+#include "rbbst.h"
+#include "scapegoatbst.h"
+#include "tracebst.h"
+
+using namespace std;
+
+// Usage: ./bst-replay trace-file [engine...]
+// Engines: bst avl splay rb scapegoat map. Runs every engine when none
+// is named. Record a trace with TracedTree (see tracebst.h), or run
+// ./bst-bench trace to write bst-bench.trace.
+
+template<typename Key>
+struct TracedOp
+{
+    TraceOp op;
+    Key key;
+};
+
+/**
+* Decodes the whole trace up front so reading it isn't timed.
+*/
+template<typename Key>
+vector<TracedOp<Key> > loadTrace(istream& in)
+{
+    TraceReader<Key> reader(in);
+    vector<TracedOp<Key> > ops;
+    TracedOp<Key> op;
+    op.key = Key();
+    while(reader.next(op.op, op.key)) {
+        ops.push_back(op);
+    }
+    return ops;
+}
+
+// Every engine replays through these, so the loop below doesn't care
+// which one it has.
+
+template<typename Tree, typename Key>
+void replayInsert(Tree& tree, const Key& key)
+{
+    tree.insert(make_pair(key, 0));
+}
+
+template<typename Tree, typename Key>
+void replayRemove(Tree& tree, const Key& key)
+{
+    tree.remove(key);
+}
+
+template<typename Key>
+void replayRemove(map<Key, int>& tree, const Key& key)
+{
+    tree.erase(key);
+}
+
+template<typename Tree, typename Key>
+bool replayFind(Tree& tree, const Key& key)
+{
+    return tree.find(key) != tree.end();
+}
+
+template<typename Tree>
+size_t replayIterate(Tree& tree)
+{
+    size_t items = 0;
+    for(typename Tree::iterator it = tree.begin(); it != tree.end(); ++it) {
+        items += (it->second == 0);
+    }
+    return items;
+}
+
+static void reportPercentiles(const string& name, vector<double>& latencies)
+{
+    if(latencies.empty()) {
+        return;
+    }
+    sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    double total = 0;
+    for(size_t i = 0; i < n; ++i) {
+        total += latencies[i];
+    }
+    cout << left << setw(22) << name << right << setw(10) << n << " ops" << fixed << setprecision(0)
+         << " mean " << setw(6) << (total / n)
+         << " p50 " << setw(6) << latencies[n / 2]
+         << " p90 " << setw(6) << latencies[n * 9 / 10]
+         << " p99 " << setw(6) << latencies[n * 99 / 100]
+         << " p99.9 " << setw(7) << latencies[n * 999 / 1000]
+         << " max " << setw(8) << latencies[n - 1] << " ns" << endl;
+}
+
+/**
+* Runs every op against a fresh tree, timing each one on its own, and
+* prints throughput and per-op latency percentiles.
+*/
+template<typename Tree, typename Key>
+void replay(const string& engine, const vector<TracedOp<Key> >& ops)
+{
+    Tree tree;
+    vector<double> latencies[TRACE_ITERATE + 1];
+    size_t sink = 0;
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for(size_t i = 0; i < ops.size(); ++i) {
+        Clock::time_point before = Clock::now();
+        switch(ops[i].op) {
+        case TRACE_INSERT:
+            replayInsert(tree, ops[i].key);
+            break;
+        case TRACE_REMOVE:
+            replayRemove(tree, ops[i].key);
+            break;
+        case TRACE_FIND:
+            sink += replayFind(tree, ops[i].key);
+            break;
+        case TRACE_ITERATE:
+            sink += replayIterate(tree);
+            break;
+        }
+        latencies[ops[i].op].push_back(chrono::duration<double, nano>(Clock::now() - before).count());
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    cout << "-- " << engine << ": " << ops.size() << " ops in " << fixed << setprecision(3) << seconds
+         << " s, " << setprecision(0) << (ops.size() / seconds) << " ops/s (" << sink % 2 << ")" << endl;
+    reportPercentiles(engine + " insert", latencies[TRACE_INSERT]);
+    reportPercentiles(engine + " remove", latencies[TRACE_REMOVE]);
+    reportPercentiles(engine + " find", latencies[TRACE_FIND]);
+    reportPercentiles(engine + " iterate", latencies[TRACE_ITERATE]);
+}
+
+template<typename Key>
+int replayAll(istream& in, const vector<string>& engines)
+{
+    vector<TracedOp<Key> > ops = loadTrace<Key>(in);
+    for(size_t i = 0; i < engines.size(); ++i) {
+        const string& engine = engines[i];
+        if(engine == "bst") replay<BinarySearchTree<Key, int> >(engine, ops);
+        else if(engine == "avl") replay<AVLTree<Key, int> >(engine, ops);
+        else if(engine == "splay") replay<SplayTree<Key, int> >(engine, ops);
+        else if(engine == "rb") replay<RedBlackTree<Key, int> >(engine, ops);
+        else if(engine == "scapegoat") replay<ScapegoatTree<Key, int> >(engine, ops);
+        else if(engine == "map") replay<map<Key, int> >(engine, ops);
+        else {
+            cout << "Unknown engine " << engine << "; expected bst, avl, splay, rb, scapegoat or map" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2) {
+        cout << "Usage: " << argv[0] << " trace-file [bst|avl|splay|rb|scapegoat|map ...]" << endl;
+        return 1;
+    }
+    ifstream in(argv[1], ios::binary);
+    if(!in) {
+        cout << "Can't open " << argv[1] << endl;
+        return 1;
+    }
+    vector<string> engines(argv + 2, argv + argc);
+    if(engines.empty()) {
+        const char* all[] = { "bst", "avl", "splay", "rb", "scapegoat", "map" };
+        engines.assign(all, all + 6);
+    }
+
+    try {
+        if(TraceIO::readHeader(in) == 'i') {
+            in.seekg(0);
+            return replayAll<long long>(in, engines);
+        }
+        in.seekg(0);
+        return replayAll<string>(in, engines);
+    }
+    catch(const exception& e) {
+        cout << argv[1] << ": " << e.what() << endl;
+        return 1;
+    }
+}
@@ -1,10 +1,34 @@
 #include <iostream>
 #include <map>
+#include <string>
+#include <functional>
+#include <sstream>
 #include "bst.h"
 #include "avlbst.h"
+#include "splaybst.h"
+#include "rbbst.h"
+#include "scapegoatbst.h"
+#include "lazyavlbst.h"
+#include "augmentedbst.h"
+#include "intervalbst.h"
+#include "multiavlbst.h"
+#include "fixedavlbst.h"
+#include "lrubst.h"
+#include "intrusivebst.h"
+#include "tracebst.h"
 
 using namespace std;
 
+struct Player : public IntrusiveAVLHook<Player>
+{
+    int id;
+    string name;
+};
+
+struct PlayerId
+{
+    const int& operator()(const Player& p) const { return p.id; }
+};
 
 int main(int argc, char *argv[])
 {
@@ -44,5 +68,295 @@ int main(int argc, char *argv[])
     cout << "Erasing b" << endl;
     at.remove('b');
 
+    // Splay Tree Tests
+    SplayTree<char,int> sp;
+    sp.insert(std::make_pair('a',1));
+    sp.insert(std::make_pair('b',2));
+
+    cout << "\nSplayTree contents:" << endl;
+    for(SplayTree<char,int>::iterator it = sp.begin(); it != sp.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    if(sp.find('a') != sp.end()) {
+        cout << "Found a" << endl;
+    }
+    else {
+        cout << "Did not find a" << endl;
+    }
+    cout << "Erasing b" << endl;
+    sp.remove('b');
+
+    // Red-Black Tree Tests
+    RedBlackTree<char,int> rb;
+    rb.insert(std::make_pair('a',1));
+    rb.insert(std::make_pair('b',2));
+
+    cout << "\nRedBlackTree contents:" << endl;
+    for(RedBlackTree<char,int>::iterator it = rb.begin(); it != rb.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    cout << "Erasing b" << endl;
+    rb.remove('b');
+
+    // Scapegoat Tree Tests
+    ScapegoatTree<int,int> sg;
+    for(int i = 1; i <= 7; i++) {
+        sg.insert(std::make_pair(i,i*10));
+    }
+    sg.remove(4);
+    cout << "\nScapegoatTree contents after erasing 4 (" << sg.size() << " items):" << endl;
+    for(ScapegoatTree<int,int>::iterator it = sg.begin(); it != sg.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // Lazy AVL Tree Tests
+    LazyAVLTree<int,int> lazy;
+    for(int i = 1; i <= 8; i++) {
+        lazy.insert(std::make_pair(i,i*10));
+    }
+    lazy.remove(3);
+    lazy.remove(6);
+    cout << "\nLazyAVLTree after erasing 3 and 6 (" << lazy.size() << " items, "
+         << lazy.deadCount() << " tombstones):" << endl;
+    for(LazyAVLTree<int,int>::iterator it = lazy.begin(); it != lazy.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    lazy.remove(1);
+    cout << "after erasing 1: " << lazy.size() << " items, " << lazy.deadCount() << " tombstones" << endl;
+
+    // Copy and move tests
+    AVLTree<char,int> copied(at);
+    copied.insert(std::make_pair('z',26));
+    AVLTree<char,int> moved(std::move(copied));
+    cout << "\nCopied AVLTree with z added, then moved (source now "
+         << (copied.empty() ? "empty" : "not empty") << "):" << endl;
+    for(AVLTree<char,int>::iterator it = moved.begin(); it != moved.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // Parallel traversal tests
+    AVLTree<int,int> big;
+    for(int i = 1; i <= 1000; i++) {
+        big.insert(std::make_pair(i,i));
+    }
+    long long total = big.parallelReduce(0LL,
+        [](const std::pair<const int,int>& item) { return (long long)item.second; },
+        [](long long a, long long b) { return a + b; }, 4);
+    cout << "\nparallelReduce sum of 1..1000 on 4 threads: " << total << endl;
+    string firstKeys = moved.parallelReduce(string(),
+        [](const std::pair<const char,int>& item) { return string(1, item.first); },
+        [](const string& a, const string& b) { return a + b; }, 4);
+    cout << "parallelReduce keys in order: " << firstKeys << endl;
+
+    // Augmented AVL Tree Tests
+    AugmentedAVLTree<int,int,SumMonoid<int,int> > sums;
+    for(int i = 1; i <= 10; i++) {
+        sums.insert(std::make_pair(i,i*i));
+    }
+    sums.remove(5);
+    cout << "\nSum of squares for keys in [3, 8) without 5: " << sums.aggregate(3,8) << endl;
+
+    // Interval Tree Tests
+    IntervalTree<int,string> rooms;
+    rooms.insert(9,11,string("standup"));
+    rooms.insert(10,12,string("review"));
+    rooms.insert(13,14,string("lunch"));
+    cout << "\nIntervals containing 10:" << endl;
+    std::vector<IntervalTree<int,string>::iterator> hits = rooms.stab(10);
+    for(size_t i = 0; i < hits.size(); i++) {
+        cout << "[" << hits[i]->first.first << ", " << hits[i]->first.second << ") " << hits[i]->second << endl;
+    }
+
+    // Multimap Tests
+    MultiAVLTree<string,int> scores;
+    scores.insert(std::make_pair(string("ann"),90));
+    scores.insert(std::make_pair(string("bob"),75));
+    scores.insert(std::make_pair(string("ann"),85));
+    scores.insert(std::make_pair(string("ann"),70));
+    scores.removeOne("ann");
+    cout << "\nann's scores after dropping the first (" << scores.count("ann") << " left):" << endl;
+    std::pair<MultiAVLTree<string,int>::iterator, MultiAVLTree<string,int>::iterator> annRange = scores.equal_range("ann");
+    for(MultiAVLTree<string,int>::iterator it = annRange.first; it != annRange.second; ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // Fixed Capacity Tree Tests
+    constexpr FixedAVLTree<int,char,8> grades = {{90,'A'},{80,'B'},{70,'C'},{60,'D'}};
+    static_assert(grades.contains(80), "built and searched at compile time");
+    FixedAVLTree<int,char,8> curve(grades);
+    curve.remove(60);
+    curve[70] = 'B';
+    cout << "\nFixedAVLTree after a curve (" << curve.size() << " of " << curve.capacity() << " slots):" << endl;
+    for(FixedAVLTree<int,char,8>::iterator it = curve.begin(); it != curve.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // Erase by iterator tests
+    AVLTree<int,int> span;
+    for(int i = 1; i <= 10; i++) {
+        span.insert(std::make_pair(i,i*i));
+    }
+    AVLTree<int,int>::iterator afterTwo = span.erase(span.find(2));
+    span.erase(span.lower_bound(5), span.lower_bound(9));
+    cout << "\nAVLTree 1..10 after erasing 2 (next was " << afterTwo->first << ") and [5, 9):" << endl;
+    for(AVLTree<int,int>::iterator it = span.begin(); it != span.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // LRU Cache Tests
+    LRUTree<string,int> recent(3);
+    recent.insert(std::make_pair(string("alpha"),1));
+    recent.insert(std::make_pair(string("bravo"),2));
+    recent.insert(std::make_pair(string("charlie"),3));
+    recent.find("alpha");
+    recent.insert(std::make_pair(string("delta"),4));
+    cout << "\nLRUTree of 3 after touching alpha and adding delta:" << endl;
+    for(LRUTree<string,int>::iterator it = recent.begin(); it != recent.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // Intrusive Tree Tests
+    Player roster[3];
+    roster[0].id = 7; roster[0].name = "mia";
+    roster[1].id = 3; roster[1].name = "leo";
+    roster[2].id = 5; roster[2].name = "ada";
+    IntrusiveAVLTree<Player,int,PlayerId> byId;
+    for(int i = 0; i < 3; i++) {
+        byId.insert(roster[i]);
+    }
+    byId.remove(7);
+    cout << "\nIntrusiveAVLTree after unlinking 7 (mia " << (roster[0].isLinked() ? "still linked" : "unlinked") << "):" << endl;
+    for(IntrusiveAVLTree<Player,int,PlayerId>::iterator it = byId.begin(); it != byId.end(); ++it) {
+        cout << it->id << " " << it->name << endl;
+    }
+
+    // Tree shape tests
+    TreeShape spanShape = span.shape();
+    cout << "\nShape of that AVLTree: " << spanShape.nodes << " nodes, height " << spanShape.height
+         << ", leaves at depths " << spanShape.minLeafDepth << " to " << spanShape.maxLeafDepth << ", level widths";
+    for(size_t d = 0; d < spanShape.levelWidths.size(); d++) {
+        cout << " " << spanShape.levelWidths[d];
+    }
+    cout << endl;
+
+    // Tree export tests
+    TreeExportOptions topOnly;
+    topOnly.maxDepth = 1;
+    cout << "\nTop two levels of that AVLTree as JSON:" << endl;
+    span.exportTree(cout, TREE_JSON, topOnly);
+
+    // Trace recorder tests
+    stringstream traceLog;
+    TracedTree<int,int> traced;
+    traced.insert(std::make_pair(5,50));
+    traced.startTrace(traceLog);
+    traced.insert(std::make_pair(3,30));
+    traced.find(3);
+    for(TracedTree<int,int>::iterator it = traced.begin(); it != traced.end(); ++it) { }
+    traced.remove(5);
+    traced.stopTrace();
+    traced.find(3);
+    cout << "\nTracedTree recorded " << traceLog.str().size() << " bytes:";
+    TraceReader<int> replayed(traceLog);
+    TraceOp op;
+    int opKey = 0;
+    const char* opNames[] = { "", "insert", "remove", "find", "iterate" };
+    while(replayed.next(op, opKey)) {
+        cout << " " << opNames[op];
+        if(op != TRACE_ITERATE) {
+            cout << " " << opKey;
+        }
+    }
+    cout << endl;
+
+    // Memory usage tests
+    AVLTree<string,string> sized;
+    sized.insert(std::make_pair(string("short"), string("s")));
+    sized.insert(std::make_pair(string("a key long enough to need the heap"), string("v")));
+    TreeMemoryUsage usage = sized.memoryUsage();
+    cout << "\nAVLTree<string,string> memory: " << usage.nodes << " nodes of " << usage.nodeSize
+         << " bytes (" << usage.nodeAllocated << " allocated), " << usage.heapBytes
+         << " heap bytes, " << usage.total() << " total" << endl;
+
+    // Compaction tests
+    AVLTree<int,int> compacted;
+    for(int i = 0; i < 100; i++) {
+        compacted.insert(std::make_pair((i * 37) % 100, i));
+    }
+    int compactSlices = 1;
+    while(!compacted.compact(16)) {
+        compactSlices++;
+    }
+    compacted.remove(50);
+    compacted.insert(std::make_pair(150, 150));
+    int compactedItems = 0;
+    for(AVLTree<int,int>::iterator it = compacted.begin(); it != compacted.end(); ++it) {
+        compactedItems++;
+    }
+    cout << "\nCompacted in " << compactSlices << " slices: " << compacted.memoryUsage().compactedNodes
+         << " nodes in blocks, " << compactedItems << " items, balanced " << compacted.isBalanced() << endl;
+    AVLTree<int,int>::iterator stale = compacted.find(150);
+    compacted.compact();
+    bool staleThrew = false;
+    try {
+        ++stale;
+    }
+    catch(std::logic_error&) {
+        staleThrew = true;
+    }
+    cout << "Iterator from before compact(): valid " << stale.valid() << ", threw " << staleThrew << endl;
+
+    // Size and ends tests
+    RedBlackTree<int,int> ends;
+    for(int i = 0; i < 10; i++) {
+        ends.insert(std::make_pair((i * 7) % 10, i));
+    }
+    ends.remove(0);
+    ends.remove(9);
+    cout << "\nSize " << ends.size() << ", first " << ends.begin()->first << ", last " << ends.back().first << ", backwards:";
+    RedBlackTree<int,int>::iterator back = ends.end();
+    while(back != ends.begin()) {
+        --back;
+        cout << " " << back->first;
+    }
+    cout << endl;
+
+    // Find cache tests
+    AVLTree<int,int> cachedFinds;
+    cachedFinds.enableFindCache(64);
+    for(int i = 0; i < 100; i++) {
+        cachedFinds.insert(std::make_pair(i, i * i));
+    }
+    int cachedSum = 0;
+    for(int round = 0; round < 10; round++) {
+        for(int i = 0; i < 5; i++) {
+            cachedSum += cachedFinds.find(i * 20)->second;
+        }
+    }
+    cachedFinds.remove(20);
+    FindCacheStats cacheStats = cachedFinds.findCacheStats();
+    cout << "\nFind cache: sum " << cachedSum << ", " << cacheStats.hits << " hits, " << cacheStats.misses
+         << " misses, 20 found after remove " << (cachedFinds.find(20) != cachedFinds.end()) << endl;
+
+    // Custom comparator tests
+    AVLTree<string,int,ThreeWayStringCompare> st;
+    st.insert(std::make_pair(string("banana"),2));
+    st.insert(std::make_pair(string("apple"),1));
+    st.insert(std::make_pair(string("cherry"),3));
+
+    cout << "\nAVLTree<string> contents:" << endl;
+    for(AVLTree<string,int,ThreeWayStringCompare>::iterator it = st.begin(); it != st.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    AVLTree<int,char,std::greater<int> > gt;
+    for(int i = 1; i <= 5; i++) {
+        gt.insert(std::make_pair(i,(char)('a' + i - 1)));
+    }
+    cout << "\nAVLTree with std::greater contents:" << endl;
+    for(AVLTree<int,char,std::greater<int> >::iterator it = gt.begin(); it != gt.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
     return 0;
 }
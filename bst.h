@@ -3,8 +3,23 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
 #include <cstdlib>
 #include <utility>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <atomic>
+#include <thread>
+#include "workpool.h"
+#include "treeshape.h"
+#include "treeexport.h"
+#include "memusage.h"
+#include "nodearena.h"
+#include "findcache.h"
 
 /**
  * A templated class for a Node in a search tree.
@@ -18,6 +33,7 @@ class Node
 {
 public:
     Node(const Key& key, const Value& value, Node<Key, Value>* parent);
+    Node(const Key& key, Value&& value, Node<Key, Value>* parent);
     virtual ~Node();
 
     const std::pair<const Key, Value>& getItem() const;
@@ -35,7 +51,24 @@ public:
     void setRight(Node<Key, Value>* right);
     void setValue(const Value &value);
 
+    // Allocates a copy of this node's item and per-node data under parent.
+    // The copy's children are left NULL. Node subclasses override this so
+    // trees can be copied without knowing their node type.
+    virtual Node<Key, Value>* clone(Node<Key, Value>* parent) const;
+    // Builds this node's replacement in the nodeSize() bytes at where,
+    // for compact(): the key is copied, the value is moved out of this
+    // node, and per-node data is copied as in clone(). The new node's
+    // children are left NULL, and this node is only fit to be freed.
+    virtual Node<Key, Value>* moveInto(void* where, Node<Key, Value>* parent);
+    // sizeof this node's actual type, for memoryUsage() and compact().
+    // Subclasses override it alongside clone().
+    virtual size_t nodeSize() const;
+
 protected:
+    // The tree's hot loops read the links directly rather than through
+    // the virtual getters; every subclass getter returns these same links.
+    template <typename, typename, typename> friend class BinarySearchTree;
+
     std::pair<const Key, Value> item_;
     Node<Key, Value>* parent_;
     Node<Key, Value>* left_;
@@ -61,6 +94,16 @@ Node<Key, Value>::Node(const Key& key, const Value& value, Node<Key, Value>* par
 
 }
 
+template<typename Key, typename Value>
+Node<Key, Value>::Node(const Key& key, Value&& value, Node<Key, Value>* parent) :
+    item_(key, std::move(value)),
+    parent_(parent),
+    left_(NULL),
+    right_(NULL)
+{
+
+}
+
 /**
 * Destructor, which does not need to do anything since the pointers inside of a node
 * are only used as references to existing nodes. The nodes pointed to by parent/left/right
@@ -180,30 +223,129 @@ void Node<Key, Value>::setValue(const Value& value)
     item_.second = value;
 }
 
+/**
+* Copies the item into a new Node.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* Node<Key, Value>::clone(Node<Key, Value>* parent) const
+{
+    return new Node<Key, Value>(item_.first, item_.second, parent);
+}
+
+template<typename Key, typename Value>
+Node<Key, Value>* Node<Key, Value>::moveInto(void* where, Node<Key, Value>* parent)
+{
+    return new(where) Node<Key, Value>(item_.first, std::move(item_.second), parent);
+}
+
+template<typename Key, typename Value>
+size_t Node<Key, Value>::nodeSize() const
+{
+    return sizeof(Node<Key, Value>);
+}
+
 /*
   ---------------------------------------
   End implementations for the Node class.
   ---------------------------------------
 */
 
+/**
+* Detects the optional three-way comparison hook on a comparator: a member
+* int compare(const A& a, const B& b) const that returns a negative number,
+* zero or a positive number as a is less than, equal to or greater than b.
+* Comparators without one are used as a plain strict weak ordering.
+*/
+template <typename Compare, typename A, typename B>
+class HasThreeWayCompare
+{
+    template <typename C>
+    static char test(decltype(std::declval<const C&>().compare(std::declval<const A&>(), std::declval<const B&>()))*);
+    template <typename C>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<Compare>(0)) == sizeof(char);
+};
+
+/**
+* Tag for the descent used when the stored and the looked-up keys are both
+* arithmetic and the comparator has no three-way hook. Such keys compare
+* in one instruction, so that descent picks the next child with a
+* conditional move instead of a branch that mispredicts about half the
+* time, and prefetches both children a level ahead.
+*/
+struct BranchlessDescent { };
+
+template <typename Key, typename K, typename Compare>
+struct DescentTag
+{
+    typedef typename std::conditional<HasThreeWayCompare<Compare, K, Key>::value, std::true_type,
+        typename std::conditional<std::is_arithmetic<Key>::value && std::is_arithmetic<K>::value,
+            BranchlessDescent, std::false_type>::type>::type type;
+};
+
+/**
+* A ready-made comparator for std::string keys (or anything else with a
+* compare() member) that lets each level of a descent make a single
+* three-way comparison. It is transparent, so string_view and const char*
+* lookups work without building a temporary std::string.
+*/
+struct ThreeWayStringCompare
+{
+    typedef void is_transparent;
+
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const { return a < b; }
+    // b is the stored key during a descent, so a may be a string_view or const char*
+    template <typename A, typename B>
+    int compare(const A& a, const B& b) const { return -b.compare(a); }
+};
+
 /**
 * A templated unbalanced binary search tree.
+* Keys are ordered by Compare, which defaults to std::less<Key>.
 */
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Compare = std::less<Key> >
 class BinarySearchTree
 {
 public:
     BinarySearchTree(); //TODO
+    explicit BinarySearchTree(const Compare& comp);
+    BinarySearchTree(const BinarySearchTree& other);
+    BinarySearchTree(BinarySearchTree&& other) noexcept;
+    BinarySearchTree& operator=(const BinarySearchTree& other);
+    BinarySearchTree& operator=(BinarySearchTree&& other) noexcept;
     virtual ~BinarySearchTree(); //TODO
+    void swap(BinarySearchTree& other) noexcept;
     virtual void insert(const std::pair<const Key, Value>& keyValuePair); //TODO
     virtual void remove(const Key& key); //TODO
-    void clear(); //TODO
+    virtual void clear(); //TODO
     bool isBalanced() const; //TODO
     void print() const;
     bool empty() const;
+    Compare key_comp() const;
 
     template<typename PPKey, typename PPValue>
     friend void prettyPrintBST(BinarySearchTree<PPKey, PPValue> & tree);
+protected:
+    /**
+    * What an iterator holds in place of its tree. Every tree has a live
+    * anchor; compact() retires it for a new one before moving any node,
+    * so iterators made before then can tell their node may be gone. A
+    * move or swap hands the anchor on with the nodes, so iterators follow
+    * their items into the tree that now holds them. Retired anchors are
+    * kept, chained off the live one, until the tree is cleared.
+    */
+    struct IteratorAnchor
+    {
+        IteratorAnchor(const BinarySearchTree* t, IteratorAnchor* o) : tree(t), newer(nullptr), older(o) {}
+
+        const BinarySearchTree* tree;
+        // NULL while live
+        IteratorAnchor* newer;
+        IteratorAnchor* older;
+    };
+
 public:
     /**
     * An internal iterator class for traversing the contents of the BST.
@@ -220,25 +362,123 @@ public:
         bool operator!=(const iterator& rhs) const;
 
         iterator& operator++();
+        // Steps back in order; end() steps back to the last item. Only
+        // iterators that came from a tree can step back from end().
+        iterator& operator--();
+
+        // False once compact() has moved nodes since this iterator was
+        // made; the end iterator never goes stale. Dereferencing or
+        // stepping a stale iterator throws std::logic_error.
+        bool valid() const;
 
     protected:
-        friend class BinarySearchTree<Key, Value>;
-        iterator(Node<Key,Value>* ptr);
+        friend class BinarySearchTree<Key, Value, Compare>;
+        iterator(Node<Key,Value>* ptr, const BinarySearchTree<Key, Value, Compare>* tree = NULL);
+        // Throws std::logic_error unless valid()
+        void checkValid() const;
         Node<Key, Value> *current_;
+        // The tree's live anchor when this iterator was made
+        IteratorAnchor* anchor_;
     };
 
 public:
     iterator begin() const;
     iterator end() const;
+    // Both O(1): the tree keeps its item count and its first and last
+    // nodes up to date. back() throws std::out_of_range on an empty tree.
+    size_t size() const;
+    std::pair<const Key, Value>& back() const;
     iterator find(const Key& key) const;
+    size_t count(const Key& key) const;
+    bool contains(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
     Value& operator[](const Key& key);
     Value const & operator[](const Key& key) const;
 
+    // Heterogeneous lookups: when Compare declares is_transparent (e.g.
+    // std::less<> or ThreeWayStringCompare) these accept any type the
+    // comparator can order against Key, so no temporary Key is built.
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    size_t count(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    bool contains(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value& operator[](const K& key);
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value const & operator[](const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    void remove(const K& key);
+
+    // Removes the item an iterator points at without searching for it
+    // again, and returns an iterator to the item after it. Iterators to
+    // other items stay valid.
+    iterator erase(iterator pos);
+    // Removes the items in [first, last) and returns last.
+    iterator erase(iterator first, iterator last);
+
+    // Parallel traversals. The tree is cut into disjoint key ranges that
+    // run on a work-stealing pool of the given number of threads (0 means
+    // one per hardware thread), so f and map may run concurrently on
+    // different items. The tree must not change until they return.
+    // parallelReduce combines results in key order, so combine needs to
+    // be associative but not commutative, and identity must be neutral.
+    template<typename Func>
+    void parallelForEach(Func f, unsigned threads = 0) const;
+    template<typename T, typename Map, typename Combine>
+    T parallelReduce(const T& identity, Map map, Combine combine, unsigned threads = 0) const;
+
+    // Node count, height, leaf depths and level widths from one pass over
+    // the tree. See treeShape() for what threads does; 1 runs serially.
+    TreeShape shape(unsigned threads = 1) const;
+
+    // Streams the tree, or the subtree rooted at key, to out as Graphviz
+    // DOT or JSON in one pass, with no depth cap (unlike print()). The
+    // options can limit the depth or sample nodes; see treeexport.h.
+    // exportSubtree throws std::out_of_range if key is not in the tree.
+    void exportTree(std::ostream& out, TreeExportFormat format,
+                    const TreeExportOptions& options = TreeExportOptions()) const;
+    void exportSubtree(const Key& key, std::ostream& out, TreeExportFormat format,
+                       const TreeExportOptions& options = TreeExportOptions()) const;
+
+    // Memory held by the nodes and by whatever the keys and values
+    // allocate, found in one O(n) pass; see memusage.h, and specialize
+    // HeapBytes there for key or value types that own heap memory.
+    TreeMemoryUsage memoryUsage() const;
+
+    // Moves the nodes into contiguous blocks laid out in van Emde Boas
+    // order, so lookups and scans touch fewer cache lines and pages than
+    // they do once churn has scattered the nodes over the heap. Moves at
+    // most maxNodes nodes per call, taking them in key order from where
+    // the last call stopped, and returns true once a whole pass is done.
+    // The tree can be used and changed as usual between calls. Each call
+    // that moves nodes invalidates every iterator made before it except
+    // end(); using one of those throws std::logic_error rather than
+    // reading a freed node, and iterator::valid() says which they are.
+    bool compact(size_t maxNodes = size_t(-1));
+
+    // Puts a cache of about slots recently found keys in front of find(),
+    // operator[], contains() and remove(), so a hit skips the descent
+    // from the root. Keys are hashed with Hash. Turning it on again
+    // starts a new, empty cache. A cached find() writes to the cache, so
+    // a tree with the cache on must not be searched from two threads at
+    // once, even through const methods.
+    template<typename Hash = std::hash<Key> >
+    void enableFindCache(size_t slots = 1024);
+    void disableFindCache();
+    // Hits and misses since the cache was turned on; all zero while off
+    FindCacheStats findCacheStats() const;
+
 protected:
     // Mandatory helper functions
     Node<Key, Value>* internalFind(const Key& k) const; // TODO
     Node<Key, Value> *getSmallestNode() const;  // TODO
     static Node<Key, Value>* predecessor(Node<Key, Value>* current); // TODO
+    // Returns the next node in key order, or NULL after the last one.
+    static Node<Key, Value>* successor(Node<Key, Value>* current);
     // Note:  static means these functions don't have a "this" pointer
     //        and instead just use the input argument.
 
@@ -246,14 +486,122 @@ protected:
     virtual void printRoot (Node<Key, Value> *r) const;
     virtual void nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2) ;
 
+    // Unlinks and deletes a node that is known to be in the tree. Every
+    // removal goes through here, so balanced trees override this rather
+    // than remove().
+    virtual void removeNode(Node<Key, Value>* n);
+    // Removes the nodes from first up to, but not including, last (NULL
+    // for the end). This removes them one at a time through removeNode;
+    // AVLTree overrides it to cut the whole range out at once.
+    virtual void eraseRange(Node<Key, Value>* first, Node<Key, Value>* last);
+
     // Add helper functions here
 
     void helpClear(Node<Key, Value>* nodeToDelete); // helper function for clear so it can have 0(n) runtime 
     int helpBalance(Node<Key, Value>* n) const; // helper to help balance 
 
+    // Walks down from root_ toward key making a single comparison per level.
+    // Returns the node holding key, or NULL with parent/isLeft naming the
+    // empty slot where key would be attached.
+    template<typename K>
+    Node<Key, Value>* descend(const K& key, Node<Key, Value>*& parent, bool& isLeft) const;
+    template<typename K>
+    Node<Key, Value>* descend(const K& key, Node<Key, Value>*& parent, bool& isLeft, std::true_type) const;
+    template<typename K>
+    Node<Key, Value>* descend(const K& key, Node<Key, Value>*& parent, bool& isLeft, std::false_type) const;
+    template<typename K>
+    Node<Key, Value>* descend(const K& key, Node<Key, Value>*& parent, bool& isLeft, BranchlessDescent) const;
+
+    // Three-way comparison of key against a stored key, using the
+    // comparator's compare() hook when it has one.
+    template<typename K>
+    int compareKeys(const K& key, const Key& nodeKey) const;
+    template<typename K>
+    int compareKeys(const K& key, const Key& nodeKey, std::true_type) const;
+    template<typename K>
+    int compareKeys(const K& key, const Key& nodeKey, std::false_type) const;
+
+    // Returns the first node whose key is not less than key, or NULL.
+    template<typename K>
+    Node<Key, Value>* lowerBoundNode(const K& key) const;
+
+    // Wraps a node in an iterator for derived trees, which can't reach
+    // the iterator's protected constructor.
+    iterator iteratorAt(Node<Key, Value>* n) const;
+
+    // Copies the subtree rooted at n node by node, keeping its shape and
+    // per-node balance data, and returns the copy's root.
+    Node<Key, Value>* cloneSubtree(const Node<Key, Value>* n);
+
+    // Calls f on every node of the subtree rooted at n in key order,
+    // without recursion.
+    template<typename Func>
+    static void visitSubtree(Node<Key, Value>* n, Func& f);
+
+    // Core of the parallel traversals: folds visit(node) over the tree in
+    // key order. Derived trees call this to filter nodes.
+    template<typename T, typename Visit, typename Combine>
+    T parallelReduceNodes(const T& identity, Visit& visit, Combine& combine, unsigned threads) const;
+    // Forks the left subtree onto the pool while it takes the node and
+    // the right subtree, down to forkDepth; below that it runs serially.
+    template<typename T, typename Visit, typename Combine>
+    static T reduceSubtree(Node<Key, Value>* n, int depth, int forkDepth, WorkStealingPool* pool,
+                           const T& identity, Visit& visit, Combine& combine);
+
+    // Appends the subtree rooted at n to out in key order, without recursion.
+    static void flattenSubtree(Node<Key, Value>* n, std::vector<Node<Key, Value>*>& out);
+    // Relinks nodes[lo, hi), which must be in key order, into a perfectly
+    // balanced subtree under parent and returns its root. The left half
+    // never has more nodes than the right.
+    static Node<Key, Value>* linkBalanced(std::vector<Node<Key, Value>*>& nodes, size_t lo, size_t hi, Node<Key, Value>* parent);
+
+    // Every insert calls this once it has linked a new node in, before
+    // any rebalancing, so the count and the first and last nodes stay
+    // current. Rotations keep the same nodes first and last.
+    void nodeLinked(Node<Key, Value>* n);
+    // The last node, from the cache or, when a removal has cleared the
+    // cache, by walking down the right spine
+    Node<Key, Value>* getLargestNode() const;
+    // Refills the first/last cache after a removal cleared it
+    void refreshEnds();
+    // Frees a and every anchor retired before it
+    static void releaseAnchors(IteratorAnchor* a);
+    // Frees a node the tree is done with, whether it came from new or
+    // from a compacted block. Every node the tree frees goes through here.
+    void destroyNode(Node<Key, Value>* n);
+    // Just the freeing, for nodes compact() has replaced
+    void freeNode(Node<Key, Value>* n);
+    // internalFind() with the find cache on
+    Node<Key, Value>* cachedFind(const Key& key) const;
+    template<typename Hash>
+    static size_t hashKey(const Key& key);
+    // Called once compact() has moved a node, with to already linked in
+    // from's place and from about to be freed, for trees that keep links
+    // of their own between nodes.
+    virtual void nodeMoved(Node<Key, Value>* from, Node<Key, Value>* to);
+    // Moves n into the next slot of arena_ and frees the old copy.
+    void relocateNode(Node<Key, Value>* n);
+    // Appends members, positions of nodes in key order whose depths lie in
+    // [top, top + height), to order in van Emde Boas order: the top half
+    // of the levels first, then each subtree hanging below them.
+    static void vebOrder(const std::vector<int>& depths, const std::vector<size_t>& members,
+                         int top, int height, std::vector<size_t>& order);
+
 protected:
     Node<Key, Value>* root_;
-    // You should not need other data members
+    Compare comp_;
+    NodeArena arena_;
+    // The last key compact() moved, while a pass is under way
+    std::unique_ptr<Key> compactedThrough_;
+    // The find cache, when it is on
+    std::unique_ptr<FindCache<Key, Node<Key, Value> > > findCache_;
+    // What libstdc++ keeps in its header node. NULL ends with a non-empty
+    // tree mean a removal took that node and nothing has refilled them.
+    size_t count_;
+    Node<Key, Value>* leftmost_;
+    Node<Key, Value>* rightmost_;
+    // NULL only if a moved-from tree could not get a new one
+    IteratorAnchor* anchor_;
 };
 
 /*
@@ -265,8 +613,9 @@ Begin implementations for the BinarySearchTree::iterator class.
 /**
 * Explicit constructor that initializes an iterator with a given node pointer.
 */
-template<class Key, class Value>
-BinarySearchTree<Key, Value>::iterator::iterator(Node<Key,Value> *ptr) : current_(ptr)
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>::iterator::iterator(Node<Key,Value> *ptr, const BinarySearchTree<Key, Value, Compare>* tree) :
+    current_(ptr), anchor_(tree != NULL ? tree->anchor_ : nullptr)
 {
     // TODO
 }
@@ -274,8 +623,8 @@ BinarySearchTree<Key, Value>::iterator::iterator(Node<Key,Value> *ptr) : current
 /**
 * A default constructor that initializes the iterator to NULL.
 */
-template<class Key, class Value>
-BinarySearchTree<Key, Value>::iterator::iterator() : current_(nullptr)
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>::iterator::iterator() : current_(nullptr), anchor_(nullptr)
 {
     // TODO
 
@@ -284,20 +633,22 @@ BinarySearchTree<Key, Value>::iterator::iterator() : current_(nullptr)
 /**
 * Provides access to the item.
 */
-template<class Key, class Value>
+template<class Key, class Value, class Compare>
 std::pair<const Key,Value> &
-BinarySearchTree<Key, Value>::iterator::operator*() const
+BinarySearchTree<Key, Value, Compare>::iterator::operator*() const
 {
+    checkValid();
     return current_->getItem();
 }
 
 /**
 * Provides access to the address of the item.
 */
-template<class Key, class Value>
+template<class Key, class Value, class Compare>
 std::pair<const Key,Value> *
-BinarySearchTree<Key, Value>::iterator::operator->() const
+BinarySearchTree<Key, Value, Compare>::iterator::operator->() const
 {
+    checkValid();
     return &(current_->getItem());
 }
 
@@ -305,10 +656,10 @@ BinarySearchTree<Key, Value>::iterator::operator->() const
 * Checks if 'this' iterator's internals have the same value
 * as 'rhs'
 */
-template<class Key, class Value>
+template<class Key, class Value, class Compare>
 bool
-BinarySearchTree<Key, Value>::iterator::operator==(
-    const BinarySearchTree<Key, Value>::iterator& rhs) const
+BinarySearchTree<Key, Value, Compare>::iterator::operator==(
+    const BinarySearchTree<Key, Value, Compare>::iterator& rhs) const
 {
     // TODO
     return (current_ == rhs.current_);
@@ -318,10 +669,10 @@ BinarySearchTree<Key, Value>::iterator::operator==(
 * Checks if 'this' iterator's internals have a different value
 * as 'rhs'
 */
-template<class Key, class Value>
+template<class Key, class Value, class Compare>
 bool
-BinarySearchTree<Key, Value>::iterator::operator!=(
-    const BinarySearchTree<Key, Value>::iterator& rhs) const
+BinarySearchTree<Key, Value, Compare>::iterator::operator!=(
+    const BinarySearchTree<Key, Value, Compare>::iterator& rhs) const
 {
     // TODO
     return (current_ != rhs.current_);
@@ -332,11 +683,12 @@ BinarySearchTree<Key, Value>::iterator::operator!=(
 /**
 * Advances the iterator's location using an in-order sequencing
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator&
-BinarySearchTree<Key, Value>::iterator::operator++()
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator&
+BinarySearchTree<Key, Value, Compare>::iterator::operator++()
 {
     // TODO
+    checkValid();
 
     Node<Key, Value>* temp = current_; // current_ stores the current pointer to iterate through 
     Node<Key, Value>* tempParent = temp->getParent(); // tempParent keeps track of the parent of temp 
@@ -364,6 +716,43 @@ BinarySearchTree<Key, Value>::iterator::operator++()
 
 }
 
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator&
+BinarySearchTree<Key, Value, Compare>::iterator::operator--()
+{
+    checkValid();
+    if(current_ == nullptr){
+      // an end() from before a compact() is still good; catch it up
+      while(anchor_->newer != nullptr){
+        anchor_ = anchor_->newer;
+      }
+      current_ = anchor_->tree->getLargestNode();
+    }
+    else{
+      current_ = predecessor(current_);
+    }
+    return *this;
+}
+
+
+template<class Key, class Value, class Compare>
+bool BinarySearchTree<Key, Value, Compare>::iterator::valid() const
+{
+    return current_ == nullptr || anchor_ == nullptr || anchor_->newer == nullptr;
+}
+
+/**
+* Always on, not just an assert: a stale iterator points at a node
+* compact() has freed, and one load of the anchor is cheap next to
+* following that pointer.
+*/
+template<class Key, class Value, class Compare>
+void BinarySearchTree<Key, Value, Compare>::iterator::checkValid() const
+{
+    if(!valid()){
+      throw std::logic_error("iterator used after compact() moved its node");
+    }
+}
 
 /*
 -------------------------------------------------------------
@@ -380,32 +769,148 @@ Begin implementations for the BinarySearchTree class.
 /**
 * Default constructor for a BinarySearchTree, which sets the root to NULL.
 */
-template<class Key, class Value>
-BinarySearchTree<Key, Value>::BinarySearchTree() 
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>::BinarySearchTree() :
+    comp_(), count_(0), leftmost_(nullptr), rightmost_(nullptr), anchor_(new IteratorAnchor(this, nullptr))
 {
     // TODO
     root_ = nullptr; // set to nulptr for an empty tree 
 }
 
-template<typename Key, typename Value>
-BinarySearchTree<Key, Value>::~BinarySearchTree()
+/**
+* Constructs an empty tree ordered by the given comparator.
+*/
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>::BinarySearchTree(const Compare& comp) :
+    root_(nullptr), comp_(comp), count_(0), leftmost_(nullptr), rightmost_(nullptr),
+    anchor_(new IteratorAnchor(this, nullptr))
+{
+
+}
+
+/**
+* Copies other's shape and balance data directly, in O(n), with no
+* comparisons or rebalancing.
+*/
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>::BinarySearchTree(const BinarySearchTree& other) :
+    root_(nullptr), comp_(other.comp_), count_(0), leftmost_(nullptr), rightmost_(nullptr),
+    anchor_(new IteratorAnchor(this, nullptr))
+{
+    std::unique_ptr<IteratorAnchor> anchor(anchor_);
+    root_ = cloneSubtree(other.root_);
+    anchor.release();
+    count_ = other.count_;
+    refreshEnds();
+    if(other.findCache_ != nullptr){
+      findCache_.reset(new FindCache<Key, Node<Key, Value> >(*other.findCache_));
+    }
+}
+
+/**
+* Takes over other's nodes in O(1), leaving other empty. Iterators into
+* other, its end() included, stay valid and now belong to this tree: an
+* old end() steps back to this tree's last item. Iterators made from
+* other afterwards belong to other.
+*/
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>::BinarySearchTree(BinarySearchTree&& other) noexcept :
+    root_(other.root_), comp_(std::move(other.comp_)), compactedThrough_(std::move(other.compactedThrough_)),
+    findCache_(std::move(other.findCache_)), count_(other.count_), leftmost_(other.leftmost_), rightmost_(other.rightmost_),
+    anchor_(other.anchor_)
+{
+    other.root_ = nullptr;
+    other.count_ = 0;
+    other.leftmost_ = nullptr;
+    other.rightmost_ = nullptr;
+    arena_.swap(other.arena_);
+    if(anchor_ != nullptr){
+      anchor_->tree = this;
+    }
+    // without one other's iterators just go unchecked
+    other.anchor_ = new (std::nothrow) IteratorAnchor(&other, nullptr);
+}
+
+/**
+* Copy-and-swap, so this tree is unchanged if copying a node throws.
+*/
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>&
+BinarySearchTree<Key, Value, Compare>::operator=(const BinarySearchTree& other)
+{
+    if(this != &other){
+      BinarySearchTree<Key, Value, Compare> copy(other);
+      swap(copy);
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare>
+BinarySearchTree<Key, Value, Compare>&
+BinarySearchTree<Key, Value, Compare>::operator=(BinarySearchTree&& other) noexcept
+{
+    if(this != &other){
+      clear();
+      swap(other);
+    }
+    return *this;
+}
+
+/**
+* Exchanges the contents of two trees in O(1). Both must be the same kind
+* of tree, since their nodes are exchanged as-is. Every iterator, end()
+* included, goes with its items to the other tree, so move assignment
+* hands other's iterators to this tree as well.
+*/
+template<class Key, class Value, class Compare>
+void BinarySearchTree<Key, Value, Compare>::swap(BinarySearchTree& other) noexcept
+{
+    using std::swap;
+    swap(root_, other.root_);
+    swap(comp_, other.comp_);
+    arena_.swap(other.arena_);
+    compactedThrough_.swap(other.compactedThrough_);
+    findCache_.swap(other.findCache_);
+    swap(count_, other.count_);
+    swap(leftmost_, other.leftmost_);
+    swap(rightmost_, other.rightmost_);
+    swap(anchor_, other.anchor_);
+    if(anchor_ != nullptr){
+      anchor_->tree = this;
+    }
+    if(other.anchor_ != nullptr){
+      other.anchor_->tree = &other;
+    }
+}
+
+template<typename Key, typename Value, typename Compare>
+BinarySearchTree<Key, Value, Compare>::~BinarySearchTree()
 {
     // TODO
     clear(); // call the clear funcion
-
+    releaseAnchors(anchor_);
 }
 
 /**
  * Returns true if tree is empty
 */
-template<class Key, class Value>
-bool BinarySearchTree<Key, Value>::empty() const
+template<class Key, class Value, class Compare>
+bool BinarySearchTree<Key, Value, Compare>::empty() const
 {
     return root_ == NULL;
 }
 
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::print() const
+/**
+* Returns a copy of the comparator that orders the keys.
+*/
+template<class Key, class Value, class Compare>
+Compare BinarySearchTree<Key, Value, Compare>::key_comp() const
+{
+    return comp_;
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::print() const
 {
     printRoot(root_);
     std::cout << "\n";
@@ -414,35 +919,49 @@ void BinarySearchTree<Key, Value>::print() const
 /**
 * Returns an iterator to the "smallest" item in the tree
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator
-BinarySearchTree<Key, Value>::begin() const
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::begin() const
 {
-    BinarySearchTree<Key, Value>::iterator begin(getSmallestNode());
+    BinarySearchTree<Key, Value, Compare>::iterator begin(getSmallestNode(), this);
     return begin;
 }
 
 /**
 * Returns an iterator whose value means INVALID
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator
-BinarySearchTree<Key, Value>::end() const
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::end() const
 {
-    BinarySearchTree<Key, Value>::iterator end(NULL);
+    BinarySearchTree<Key, Value, Compare>::iterator end(NULL, this);
     return end;
 }
 
+template<class Key, class Value, class Compare>
+size_t BinarySearchTree<Key, Value, Compare>::size() const
+{
+    return count_;
+}
+
+template<class Key, class Value, class Compare>
+std::pair<const Key, Value>& BinarySearchTree<Key, Value, Compare>::back() const
+{
+    Node<Key, Value>* last = getLargestNode();
+    if(last == NULL) throw std::out_of_range("Empty tree");
+    return last->getItem();
+}
+
 /**
 * Returns an iterator to the item with the given key, k
 * or the end iterator if k does not exist in the tree
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator
-BinarySearchTree<Key, Value>::find(const Key & k) const
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::find(const Key & k) const
 {
     Node<Key, Value> *curr = internalFind(k);
-    BinarySearchTree<Key, Value>::iterator it(curr);
+    BinarySearchTree<Key, Value, Compare>::iterator it(curr, this);
     return it;
 }
 
@@ -450,29 +969,148 @@ BinarySearchTree<Key, Value>::find(const Key & k) const
  * @precondition The key exists in the map
  * Returns the value associated with the key
  */
-template<class Key, class Value>
-Value& BinarySearchTree<Key, Value>::operator[](const Key& key)
+template<class Key, class Value, class Compare>
+Value& BinarySearchTree<Key, Value, Compare>::operator[](const Key& key)
 {
     Node<Key, Value> *curr = internalFind(key);
     if(curr == NULL) throw std::out_of_range("Invalid key");
     return curr->getValue();
 }
-template<class Key, class Value>
-Value const & BinarySearchTree<Key, Value>::operator[](const Key& key) const
+template<class Key, class Value, class Compare>
+Value const & BinarySearchTree<Key, Value, Compare>::operator[](const Key& key) const
 {
     Node<Key, Value> *curr = internalFind(key);
     if(curr == NULL) throw std::out_of_range("Invalid key");
     return curr->getValue();
 }
 
+/**
+* Returns the number of items with the given key (0 or 1)
+*/
+template<class Key, class Value, class Compare>
+size_t BinarySearchTree<Key, Value, Compare>::count(const Key& key) const
+{
+    return internalFind(key) != NULL ? 1 : 0;
+}
+
+/**
+* Returns true if an item with the given key is in the tree
+*/
+template<class Key, class Value, class Compare>
+bool BinarySearchTree<Key, Value, Compare>::contains(const Key& key) const
+{
+    return internalFind(key) != NULL;
+}
+
+/**
+* Returns an iterator to the first item whose key is not less
+* than the given key, or the end iterator if there is none
+*/
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::lower_bound(const Key& key) const
+{
+    return iterator(lowerBoundNode(key), this);
+}
+
+/**
+* Returns an iterator that points at the given node
+*/
+template<class Key, class Value, class Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::iteratorAt(Node<Key, Value>* n) const
+{
+    return iterator(n, this);
+}
+
+/**
+* Heterogeneous version of find()
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::find(const K& key) const
+{
+    Node<Key, Value>* parent = NULL;
+    bool isLeft = false;
+    return iterator(descend(key, parent, isLeft), this);
+}
+
+/**
+* Heterogeneous version of count()
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+size_t BinarySearchTree<Key, Value, Compare>::count(const K& key) const
+{
+    return contains(key) ? 1 : 0;
+}
+
+/**
+* Heterogeneous version of contains()
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+bool BinarySearchTree<Key, Value, Compare>::contains(const K& key) const
+{
+    Node<Key, Value>* parent = NULL;
+    bool isLeft = false;
+    return descend(key, parent, isLeft) != NULL;
+}
+
+/**
+* Heterogeneous version of lower_bound()
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::lower_bound(const K& key) const
+{
+    return iterator(lowerBoundNode(key), this);
+}
+
+/**
+* Heterogeneous versions of operator[]
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+Value& BinarySearchTree<Key, Value, Compare>::operator[](const K& key)
+{
+    Node<Key, Value> *curr = find(key).current_;
+    if(curr == NULL) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+Value const & BinarySearchTree<Key, Value, Compare>::operator[](const K& key) const
+{
+    Node<Key, Value> *curr = find(key).current_;
+    if(curr == NULL) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+/**
+* Heterogeneous version of remove()
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+void BinarySearchTree<Key, Value, Compare>::remove(const K& key)
+{
+    Node<Key, Value> *curr = find(key).current_;
+    if(curr != NULL) {
+        removeNode(curr);
+        refreshEnds();
+    }
+}
+
 /**
 * An insert method to insert into a Binary Search Tree.
 * The tree will not remain balanced when inserting.
 * Recall: If key is already in the tree, you should 
 * overwrite the current value with the updated value.
 */
-template<class Key, class Value>
-void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &keyValuePair)
+template<class Key, class Value, class Compare>
+void BinarySearchTree<Key, Value, Compare>::insert(const std::pair<const Key, Value> &keyValuePair)
 {
     // TODO
 
@@ -481,37 +1119,19 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
 
       // just add new node from root 
       root_ = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, nullptr); // first is the const getter for the key, second is const getter for the value 
+      nodeLinked(root_);
       return; // done
     
     }
 
-    Node<Key, Value>* temp = root_; // start temp at the root 
     Node<Key, Value>* tempParent = nullptr; // so that we can insert the node later 
-    bool equalNodes = false; // keeps track if we found matching keys 
+    bool goLeft = false; // which side of tempParent the new node goes on 
 
-    // 1. walk the tree until find an empty location 
-    while (temp != nullptr){
-      
-      // go left if value is less than node --> value here would be the key bc that's how BST stores nodes 
-      if(keyValuePair.first < temp->getKey()){
-        tempParent = temp; // update parent
-        temp = temp->getLeft();
-      }
-      // right if greater than node
-      else if(keyValuePair.first > temp->getKey()){
-        tempParent = temp; // update parent
-        temp = temp->getRight();
-      }
-      // else the value is equal so set to reue
-      else{
-        equalNodes = true; 
-        break; // break out of the loop (temp will not be null)
-      }
-    }
+    // 1. walk the tree until we find the key or an empty location 
+    Node<Key, Value>* temp = descend(keyValuePair.first, tempParent, goLeft);
 
     // before step 2: if we found matching keys --> update the values and return 
-    if(equalNodes){
-      // becase we broke out of a loop --> temp will not be null 
+    if(temp != nullptr){
       temp->setValue(keyValuePair.second); // value is equal so need to replace value 
       return; // stop right here because we found it 
     }
@@ -520,13 +1140,14 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
     Node<Key, Value>* nodeToInsert = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, tempParent); // create a new node 
 
     // if less than set as left kid
-    if(keyValuePair.first < tempParent->getKey()){
+    if(goLeft){
       tempParent->setLeft(nodeToInsert);
     }
     // its greater than so set as right kid
     else{
       tempParent->setRight(nodeToInsert);
     }
+    nodeLinked(nodeToInsert);
 }
 
 
@@ -535,8 +1156,8 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
 * Recall: The writeup specifies that if a node has 2 children you
 * should swap with the predecessor and then remove.
 */
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::remove(const Key& key)
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::remove(const Key& key)
 {
   // TODO
 
@@ -545,31 +1166,67 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     return; // just return 
   }
 
-  Node<Key, Value>* temp = root_; // start temp at the root 
-  Node<Key, Value>* tempParent = nullptr; // so that we can remove nodes with kids 
-
   // 1. walk the tree to find the value to remove --> traverse down 
-  while(temp != nullptr){ // while ptr is not at end 
-
-    if(key < temp->getKey()){
-      tempParent = temp; // update parent 
-      temp = temp->getLeft(); // key < so go left 
-    }
-    else if(key > temp->getKey()){
-      tempParent = temp; // update parent 
-      temp = temp->getRight(); // key < so go left 
-    }
-    else {
-      // else the key matches !! 
-      break; // and temp points to the node to remove 
-    }
-  }
+  Node<Key, Value>* temp = internalFind(key);
 
   if(temp == nullptr){
     return; // key was not found :(
   }
 
   // 2. remove the node 
+  removeNode(temp);
+  refreshEnds();
+}
+
+/**
+* Every tree keeps its nodes in place through a removal (two-child
+* removals swap nodes, not items), so the successor found beforehand is
+* still the right one afterwards. That also makes it the new first node
+* when pos was the first, so popping from the front never walks.
+* @precondition pos points at an item of this tree
+*/
+template<typename Key, typename Value, typename Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::erase(iterator pos)
+{
+  iterator next = pos;
+  ++next;
+  bool first = (pos.current_ == leftmost_);
+  removeNode(pos.current_);
+  if(first){
+    leftmost_ = next.current_;
+  }
+  refreshEnds();
+  return next;
+}
+
+template<typename Key, typename Value, typename Compare>
+typename BinarySearchTree<Key, Value, Compare>::iterator
+BinarySearchTree<Key, Value, Compare>::erase(iterator first, iterator last)
+{
+  if(first != last){
+    eraseRange(first.current_, last.current_);
+    refreshEnds();
+  }
+  return last;
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::eraseRange(Node<Key, Value>* first, Node<Key, Value>* last)
+{
+  iterator it(first, this);
+  while(it.current_ != last){
+    it = erase(it);
+  }
+}
+
+/**
+* Unlinks temp from the tree and deletes it.
+*/
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::removeNode(Node<Key, Value>* temp)
+{
+  Node<Key, Value>* tempParent = temp->getParent(); // so that we can remove nodes with kids 
   
   // case if node to remove has zero kids: remove leaf 
   if(temp->getLeft() == nullptr && temp->getRight() == nullptr){
@@ -587,7 +1244,7 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
       tempParent->setRight(nullptr); 
     }
 
-    delete temp; // delete 
+    destroyNode(temp); // delete 
     return;
   } 
 
@@ -641,16 +1298,16 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
   }
 
 
-  delete temp; // delete  
+  destroyNode(temp); // delete  
   return;
 
 }
 
 
 
-template<class Key, class Value>
+template<class Key, class Value, class Compare>
 Node<Key, Value>*
-BinarySearchTree<Key, Value>::predecessor(Node<Key, Value>* current)
+BinarySearchTree<Key, Value, Compare>::predecessor(Node<Key, Value>* current)
 {
   // TODO
 
@@ -693,16 +1350,49 @@ BinarySearchTree<Key, Value>::predecessor(Node<Key, Value>* current)
   }
 }
 
+// mirror of predecessor: the leftmost node of the right subtree, or else
+// the first ancestor that current sits to the left of 
+template<class Key, class Value, class Compare>
+Node<Key, Value>*
+BinarySearchTree<Key, Value, Compare>::successor(Node<Key, Value>* current)
+{
+  if(current == nullptr){
+    return nullptr;
+  }
+
+  Node<Key, Value>* temp = current;
+  if(temp->getRight() != nullptr){
+    temp = temp->getRight();
+    while(temp->getLeft() != nullptr){
+      temp = temp->getLeft();
+    }
+    return temp;
+  }
+
+  Node<Key, Value>* tempParent = temp->getParent();
+  while(tempParent != nullptr && temp == tempParent->getRight()){
+    temp = tempParent;
+    tempParent = tempParent->getParent();
+  }
+  return tempParent;
+}
+
 
 /**
 * A method to remove all contents of the tree and
 * reset the values in the tree for use again.
 */
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::clear()
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::clear()
 {
   // TODO 
 
+  // every iterator but end() is gone now, so no retired anchor is needed
+  if(anchor_ != nullptr){
+    releaseAnchors(anchor_->older);
+    anchor_->older = nullptr;
+  }
+
   // base case: is tree is already empty, do nothing and return
   if(root_ == nullptr){
     return; 
@@ -710,34 +1400,534 @@ void BinarySearchTree<Key, Value>::clear()
 
   Node<Key, Value>* temp = root_; // store temp to root 
   root_ = nullptr; // set the root to nullptr so we still have a node but it's empty 
-  
+  compactedThrough_.reset();
+
+  // empty the find cache in one go rather than node by node
+  std::unique_ptr<FindCache<Key, Node<Key, Value> > > cache(std::move(findCache_));
   helpClear(temp); // Utilize helper function !! 
+  if(cache != nullptr){
+    cache->reset();
+    findCache_ = std::move(cache);
+  }
+  count_ = 0;
+  leftmost_ = nullptr;
+  rightmost_ = nullptr;
   return;
 }
 
 // recursive helpoer function so clear can return in 0(n)
 // takes in a node to delete
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::helpClear(Node<Key, Value>* nodeToDelete){
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::helpClear(Node<Key, Value>* nodeToDelete){
   // base case 
   if(nodeToDelete == nullptr){
     return; // end 
   }
 
-  // recursively iterate through left and right branches 
-  helpClear(nodeToDelete->getLeft());
-  helpClear(nodeToDelete->getRight()); 
+  // recursively iterate through left and right branches, reading the 
+  // links directly so no virtual getter runs per node 
+  helpClear(nodeToDelete->left_);
+  helpClear(nodeToDelete->right_); 
+
+  destroyNode(nodeToDelete);
+}
+
+
+template<typename Key, typename Value, typename Compare>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::cloneSubtree(const Node<Key, Value>* n)
+{
+  if(n == nullptr){
+    return nullptr;
+  }
+
+  // explicit stack of (original, copy) pairs whose children still need copying
+  Node<Key, Value>* copyRoot = n->clone(nullptr);
+  std::vector<std::pair<const Node<Key, Value>*, Node<Key, Value>*> > pending;
+  pending.push_back(std::make_pair(n, copyRoot));
+  try{
+    while(!pending.empty()){
+      const Node<Key, Value>* from = pending.back().first;
+      Node<Key, Value>* to = pending.back().second;
+      pending.pop_back();
+      if(from->getLeft() != nullptr){
+        to->setLeft(from->getLeft()->clone(to));
+        pending.push_back(std::make_pair(from->getLeft(), to->getLeft()));
+      }
+      if(from->getRight() != nullptr){
+        to->setRight(from->getRight()->clone(to));
+        pending.push_back(std::make_pair(from->getRight(), to->getRight()));
+      }
+    }
+  }
+  catch(...){
+    // every copy is already linked in, so this frees all of them
+    helpClear(copyRoot);
+    throw;
+  }
+  return copyRoot;
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::flattenSubtree(Node<Key, Value>* n, std::vector<Node<Key, Value>*>& out)
+{
+  auto append = [&out](Node<Key, Value>* temp){ out.push_back(temp); };
+  visitSubtree(n, append);
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename Func>
+void BinarySearchTree<Key, Value, Compare>::visitSubtree(Node<Key, Value>* n, Func& f)
+{
+  if(n == nullptr){
+    return;
+  }
+
+  // start at the leftmost node of the subtree and walk successors
+  Node<Key, Value>* temp = n;
+  while(temp->getLeft() != nullptr){
+    temp = temp->getLeft();
+  }
+
+  while(true){
+    f(temp);
+    if(temp->getRight() != nullptr){
+      temp = temp->getRight();
+      while(temp->getLeft() != nullptr){
+        temp = temp->getLeft();
+      }
+    }
+    else{
+      // climb while we are a right kid, but never above n
+      while(temp != n && temp == temp->getParent()->getRight()){
+        temp = temp->getParent();
+      }
+      if(temp == n){
+        return; // the whole subtree has been visited
+      }
+      temp = temp->getParent();
+    }
+  }
+}
+
+template<typename Key, typename Value, typename Compare>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::linkBalanced(std::vector<Node<Key, Value>*>& nodes, size_t lo, size_t hi, Node<Key, Value>* parent)
+{
+  if(lo >= hi){
+    return nullptr;
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  Node<Key, Value>* subRoot = nodes[mid];
+  subRoot->setParent(parent);
+  subRoot->setLeft(linkBalanced(nodes, lo, mid, subRoot));
+  subRoot->setRight(linkBalanced(nodes, mid + 1, hi, subRoot));
+  return subRoot;
+}
+
+/**
+* Calls f on every item, in parallel. See parallelReduce().
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename Func>
+void BinarySearchTree<Key, Value, Compare>::parallelForEach(Func f, unsigned threads) const
+{
+  auto visit = [&f](Node<Key, Value>* n) -> int { f(n->getItem()); return 0; };
+  auto ignore = [](int, int) -> int { return 0; };
+  parallelReduceNodes(0, visit, ignore, threads);
+}
+
+/**
+* Returns combine folded over map(item) for every item in key order,
+* starting from identity, computed in parallel.
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename T, typename Map, typename Combine>
+T BinarySearchTree<Key, Value, Compare>::parallelReduce(const T& identity, Map map, Combine combine, unsigned threads) const
+{
+  auto visit = [&map](Node<Key, Value>* n) -> T { return map(n->getItem()); };
+  return parallelReduceNodes(identity, visit, combine, threads);
+}
+
+template<typename Key, typename Value, typename Compare>
+TreeShape BinarySearchTree<Key, Value, Compare>::shape(unsigned threads) const
+{
+  return treeShape<Node<Key, Value> >(root_, threads);
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::exportTree(std::ostream& out, TreeExportFormat format,
+                                                       const TreeExportOptions& options) const
+{
+  ::exportTree<Node<Key, Value> >(out, root_, format, options);
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::exportSubtree(const Key& key, std::ostream& out, TreeExportFormat format,
+                                                          const TreeExportOptions& options) const
+{
+  Node<Key, Value>* n = internalFind(key);
+  if(n == NULL) throw std::out_of_range("Invalid key");
+  ::exportTree<Node<Key, Value> >(out, n, format, options);
+}
+
+/**
+* Every node in a tree has the same type, so the root says how big they
+* all are. An empty tree reports zero for everything.
+*/
+template<typename Key, typename Value, typename Compare>
+TreeMemoryUsage BinarySearchTree<Key, Value, Compare>::memoryUsage() const
+{
+  TreeMemoryUsage usage;
+  if(root_ == nullptr){
+    return usage;
+  }
+  usage.nodeSize = root_->nodeSize();
+  usage.nodeAllocated = allocatedBytes(usage.nodeSize);
+  auto count = [&usage](Node<Key, Value>* temp){
+    ++usage.nodes;
+    usage.heapBytes += HeapBytes<Key>::of(temp->getKey()) + HeapBytes<Value>::of(temp->getValue());
+  };
+  visitSubtree(root_, count);
+  usage.compactedNodes = arena_.liveSlots();
+  usage.arenaBytes = arena_.bytes();
+  return usage;
+}
+
+/**
+* Each call takes the next maxNodes nodes in key order, a stretch that
+* hangs together as pieces of subtrees, and lays them out in van Emde
+* Boas order at the end of the pass's block. A whole pass in one call
+* gives the whole tree that layout. The pass carries on from the last
+* key it moved, so inserts, removes and rebalancing in between are
+* harmless: a node inserted behind it just stays where it is.
+*/
+template<typename Key, typename Value, typename Compare>
+bool BinarySearchTree<Key, Value, Compare>::compact(size_t maxNodes)
+{
+  Node<Key, Value>* start = nullptr;
+  if(compactedThrough_ == nullptr){
+    // a new pass starts a new block rather than filling the old one
+    arena_.newRun();
+    start = root_;
+    while(start != nullptr && start->left_ != nullptr){
+      start = start->left_;
+    }
+  }
+  else{
+    // the first node past the last key moved
+    Node<Key, Value>* temp = root_;
+    while(temp != nullptr){
+      if(comp_(*compactedThrough_, temp->item_.first)){
+        start = temp;
+        temp = temp->left_;
+      }
+      else{
+        temp = temp->right_;
+      }
+    }
+  }
+  if(start == nullptr){
+    compactedThrough_.reset();
+    return true;
+  }
+
+  int depth = 0;
+  for(Node<Key, Value>* temp = start; temp->parent_ != nullptr; temp = temp->parent_){
+    ++depth;
+  }
+
+  // walk successors, keeping track of depth; equal keys are never split
+  // across calls, since the next call starts past the last key
+  std::vector<Node<Key, Value>*> slice;
+  std::vector<int> depths;
+  int minDepth = depth;
+  int maxDepth = depth;
+  Node<Key, Value>* temp = start;
+  while(temp != nullptr && (slice.size() < maxNodes || !comp_(slice.back()->item_.first, temp->item_.first))){
+    slice.push_back(temp);
+    depths.push_back(depth);
+    minDepth = std::min(minDepth, depth);
+    maxDepth = std::max(maxDepth, depth);
+    if(temp->right_ != nullptr){
+      temp = temp->right_;
+      ++depth;
+      while(temp->left_ != nullptr){
+        temp = temp->left_;
+        ++depth;
+      }
+    }
+    else{
+      while(temp->parent_ != nullptr && temp == temp->parent_->right_){
+        temp = temp->parent_;
+        --depth;
+      }
+      temp = temp->parent_;
+      --depth;
+    }
+  }
+  std::unique_ptr<Key> through(temp == nullptr ? nullptr : new Key(slice.back()->item_.first));
 
-  delete nodeToDelete;
+  std::vector<size_t> members(slice.size());
+  for(size_t i = 0; i < members.size(); ++i){
+    members[i] = i;
+  }
+  std::vector<size_t> order;
+  order.reserve(slice.size());
+  vebOrder(depths, members, minDepth, maxDepth - minDepth + 1, order);
+
+  // every node in a tree is the same type, so the root's size fits all
+  arena_.reserve(root_->nodeSize(), slice.size());
+  // before any node moves, so iterators are stale even if a move throws
+  IteratorAnchor* anchor = new IteratorAnchor(this, anchor_);
+  if(anchor_ != nullptr){
+    anchor_->newer = anchor;
+  }
+  anchor_ = anchor;
+  for(size_t i = 0; i < order.size(); ++i){
+    relocateNode(slice[order[i]]);
+  }
+  compactedThrough_ = std::move(through);
+  return compactedThrough_ == nullptr;
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::releaseAnchors(IteratorAnchor* a)
+{
+  while(a != nullptr){
+    IteratorAnchor* older = a->older;
+    delete a;
+    a = older;
+  }
 }
 
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::vebOrder(const std::vector<int>& depths, const std::vector<size_t>& members,
+                                                     int top, int height, std::vector<size_t>& order)
+{
+  if(height <= 1 || members.size() <= 1){
+    order.insert(order.end(), members.begin(), members.end());
+    return;
+  }
+
+  int topHeight = height / 2;
+  int split = top + topHeight;
+  std::vector<size_t> upper;
+  for(size_t i = 0; i < members.size(); ++i){
+    if(depths[members[i]] < split){
+      upper.push_back(members[i]);
+    }
+  }
+  vebOrder(depths, upper, top, topHeight, order);
+
+  // in key order, two subtrees below the split always have their common
+  // ancestor, a node above it, between them; so each subtree is a run
+  std::vector<size_t> lower;
+  for(size_t i = 0; i <= members.size(); ++i){
+    if(i < members.size() && depths[members[i]] >= split){
+      lower.push_back(members[i]);
+    }
+    else if(!lower.empty()){
+      vebOrder(depths, lower, split, height - topHeight, order);
+      lower.clear();
+    }
+  }
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::relocateNode(Node<Key, Value>* n)
+{
+  void* slot = arena_.allocate();
+  Node<Key, Value>* copy = nullptr;
+  try{
+    copy = n->moveInto(slot, n->parent_);
+  }
+  catch(...){
+    arena_.release(slot);
+    throw;
+  }
+
+  copy->left_ = n->left_;
+  copy->right_ = n->right_;
+  if(copy->left_ != nullptr){
+    copy->left_->parent_ = copy;
+  }
+  if(copy->right_ != nullptr){
+    copy->right_->parent_ = copy;
+  }
+  if(n->parent_ == nullptr){
+    root_ = copy;
+  }
+  else if(n->parent_->left_ == n){
+    n->parent_->left_ = copy;
+  }
+  else{
+    n->parent_->right_ = copy;
+  }
+  if(leftmost_ == n){
+    leftmost_ = copy;
+  }
+  if(rightmost_ == n){
+    rightmost_ = copy;
+  }
+  if(findCache_ != nullptr){
+    findCache_->moved(n->getKey(), n, copy);
+  }
+  nodeMoved(n, copy);
+  freeNode(n);
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::destroyNode(Node<Key, Value>* n)
+{
+  --count_;
+  if(findCache_ != nullptr){
+    findCache_->forget(n->getKey(), n);
+  }
+  if(leftmost_ == n){
+    leftmost_ = nullptr;
+  }
+  if(rightmost_ == n){
+    rightmost_ = nullptr;
+  }
+  freeNode(n);
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::freeNode(Node<Key, Value>* n)
+{
+  if(!arena_.owns(n)){
+    delete n;
+    return;
+  }
+  n->~Node<Key, Value>();
+  arena_.release(n);
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::nodeMoved(Node<Key, Value>*, Node<Key, Value>*)
+{
+}
+
+/**
+* A new node is first when nothing is left of it: it is the root with no
+* left child, or it was hung to the left of the old first node. Likewise
+* for last. If the cache was already cleared it stays cleared.
+*/
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::nodeLinked(Node<Key, Value>* n)
+{
+  ++count_;
+  Node<Key, Value>* parent = n->parent_;
+  if(n->left_ == nullptr && (parent == nullptr || (parent == leftmost_ && parent->left_ == n))){
+    leftmost_ = n;
+  }
+  if(n->right_ == nullptr && (parent == nullptr || (parent == rightmost_ && parent->right_ == n))){
+    rightmost_ = n;
+  }
+}
+
+template<typename Key, typename Value, typename Compare>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::getLargestNode() const
+{
+  if(rightmost_ != nullptr || root_ == nullptr){
+    return rightmost_;
+  }
+  Node<Key, Value>* temp = root_;
+  while(temp->right_ != nullptr){
+    temp = temp->right_;
+  }
+  return temp;
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::refreshEnds()
+{
+  if(root_ == nullptr){
+    leftmost_ = nullptr;
+    rightmost_ = nullptr;
+    return;
+  }
+  leftmost_ = getSmallestNode();
+  rightmost_ = getLargestNode();
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename T, typename Visit, typename Combine>
+T BinarySearchTree<Key, Value, Compare>::parallelReduceNodes(const T& identity, Visit& visit, Combine& combine, unsigned threads) const
+{
+  if(threads == 0){
+    threads = std::thread::hardware_concurrency();
+  }
+  if(threads <= 1 || root_ == nullptr){
+    T result(identity);
+    auto fold = [&](Node<Key, Value>* n){ result = combine(result, visit(n)); };
+    visitSubtree(root_, fold);
+    return result;
+  }
+
+  // about 8 pieces per thread near the top gives the thieves something
+  // to balance with, even when subtrees differ in size
+  int forkDepth = 3;
+  for(unsigned t = 1; t < threads; t <<= 1){
+    ++forkDepth;
+  }
+  WorkStealingPool pool(threads);
+  T result = reduceSubtree(root_, 0, forkDepth, &pool, identity, visit, combine);
+  pool.rethrowIfFailed();
+  return result;
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename T, typename Visit, typename Combine>
+T BinarySearchTree<Key, Value, Compare>::reduceSubtree(Node<Key, Value>* n, int depth, int forkDepth, WorkStealingPool* pool,
+                                                       const T& identity, Visit& visit, Combine& combine)
+{
+  if(n == nullptr){
+    return identity;
+  }
+  if(depth >= forkDepth){
+    T result(identity);
+    auto fold = [&](Node<Key, Value>* temp){ result = combine(result, visit(temp)); };
+    visitSubtree(n, fold);
+    return result;
+  }
+
+  // the left subtree becomes a task that an idle worker can steal
+  Node<Key, Value>* left = n->getLeft();
+  T leftResult(identity);
+  std::atomic<bool> leftDone(left == nullptr);
+  if(left != nullptr){
+    pool->spawn([&, left](){
+      try{
+        leftResult = reduceSubtree(left, depth + 1, forkDepth, pool, identity, visit, combine);
+      }
+      catch(...){
+        pool->fail(std::current_exception());
+      }
+      leftDone.store(true, std::memory_order_release);
+    });
+  }
+
+  T result(identity);
+  try{
+    T mid = visit(n);
+    T rightResult = reduceSubtree(n->getRight(), depth + 1, forkDepth, pool, identity, visit, combine);
+    // the left task refers to this frame, so it has to finish first
+    pool->helpUntil(leftDone);
+    result = combine(combine(leftResult, mid), rightResult);
+  }
+  catch(...){
+    pool->helpUntil(leftDone);
+    throw;
+  }
+  return result;
+}
 
 /**
 * A helper function to find the smallest node in the tree.
 */
-template<typename Key, typename Value>
+template<typename Key, typename Value, typename Compare>
 Node<Key, Value>*
-BinarySearchTree<Key, Value>::getSmallestNode() const
+BinarySearchTree<Key, Value, Compare>::getSmallestNode() const
 {
   // TODO 
 
@@ -745,6 +1935,9 @@ BinarySearchTree<Key, Value>::getSmallestNode() const
   if(root_ == nullptr){
     return root_; // just return empty head 
   }
+  if(leftmost_ != nullptr){
+    return leftmost_;
+  }
 
   // smallest node is the left most leaf 
   Node<Key, Value>* temp = root_;
@@ -759,37 +1952,229 @@ BinarySearchTree<Key, Value>::getSmallestNode() const
 * return a pointer to it or NULL if no item with that key
 * exists
 */
-template<typename Key, typename Value>
-Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) const
+template<typename Key, typename Value, typename Compare>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::internalFind(const Key& key) const
 {
-  // TODO 
+  if(findCache_ != nullptr){
+    return cachedFind(key);
+  }
+  Node<Key, Value>* tempParent = nullptr; // unused, descend reports the empty slot too 
+  bool goLeft = false;
+  return descend(key, tempParent, goLeft);
+}
 
-  Node<Key, Value>* temp = root_; // start temp at the root
+/**
+* A hit is confirmed with the comparator, so keys that hash alike but
+* compare different never get each other's node. A miss descends as
+* usual and caches what it found; keys missing from the tree are not
+* cached. Nodes only leave the cache when they are freed or moved:
+* nodeSwap() and rotations move nodes around the tree but never change
+* which key a node holds.
+*/
+template<typename Key, typename Value, typename Compare>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::cachedFind(const Key& key) const
+{
+  size_t h = findCache_->hash(key);
+  Node<Key, Value>* n = findCache_->find(h, [&](Node<Key, Value>* c){
+    return !comp_(key, c->getKey()) && !comp_(c->getKey(), key);
+  });
+  if(n != nullptr){
+    return n;
+  }
+  Node<Key, Value>* parent = nullptr;
+  bool isLeft = false;
+  n = descend(key, parent, isLeft);
+  if(n != nullptr){
+    findCache_->insert(h, n);
+  }
+  return n;
+}
 
-  // 1. walk trhe tree to find the value to remove --> traverse down 
-  while(temp != nullptr){ // while the ptr is not at the end 
+template<typename Key, typename Value, typename Compare>
+template<typename Hash>
+size_t BinarySearchTree<Key, Value, Compare>::hashKey(const Key& key)
+{
+  return Hash()(key);
+}
 
-    if(key < temp->getKey()){
-      temp = temp->getLeft(); // key < so go right 
+/**
+* The cache holds a plain function pointer for Hash, so trees whose keys
+* have no std::hash only need one when they turn the cache on.
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename Hash>
+void BinarySearchTree<Key, Value, Compare>::enableFindCache(size_t slots)
+{
+  findCache_.reset(new FindCache<Key, Node<Key, Value> >(slots, &BinarySearchTree::template hashKey<Hash>));
+}
+
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::disableFindCache()
+{
+  findCache_.reset();
+}
+
+template<typename Key, typename Value, typename Compare>
+FindCacheStats BinarySearchTree<Key, Value, Compare>::findCacheStats() const
+{
+  if(findCache_ == nullptr){
+    return FindCacheStats();
+  }
+  return findCache_->stats();
+}
+
+/**
+* Dispatches to the three-way descent when the comparator has a compare()
+* hook, to the branchless descent for arithmetic keys, and to the strict
+* weak ordering descent otherwise.
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::descend(const K& key, Node<Key, Value>*& parent, bool& isLeft) const
+{
+  return descend(key, parent, isLeft, typename DescentTag<Key, K, Compare>::type());
+}
+
+/**
+* Three-way descent: one call to compare() per level, stopping early
+* when the key is found.
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::descend(const K& key, Node<Key, Value>*& parent, bool& isLeft, std::true_type) const
+{
+  Node<Key, Value>* temp = root_; // start temp at the root
+  parent = nullptr;
+  isLeft = false;
+
+  while(temp != nullptr){
+    int result = comp_.compare(key, temp->getKey());
+    if(result == 0){
+      return temp; // keys match --> we found the key! 
     }
-    else if(key > temp->getKey()){ // right if greater than node 
-      temp = temp->getRight(); // key < so go right 
+    parent = temp;
+    isLeft = result < 0;
+    temp = isLeft ? temp->getLeft() : temp->getRight();
+  }
+
+  // not found so return nothing 
+  return nullptr;
+}
+
+/**
+* Strict weak ordering descent: one call to comp_(key, node) per level.
+* Whenever key is not less than a node we go right and remember that node;
+* the last one remembered is the only possible match, so equality is
+* checked a single time once we fall off the bottom of the tree.
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::descend(const K& key, Node<Key, Value>*& parent, bool& isLeft, std::false_type) const
+{
+  Node<Key, Value>* temp = root_; // start temp at the root
+  Node<Key, Value>* candidate = nullptr; // last node that key was not less than
+  parent = nullptr;
+  isLeft = false;
+
+  while(temp != nullptr){
+    parent = temp;
+    isLeft = comp_(key, temp->getKey());
+    if(isLeft){
+      temp = temp->getLeft();
     }
-    else {
-      // keys match --> we found the key! 
-      return temp;
+    else{
+      candidate = temp;
+      temp = temp->getRight();
     }
   }
 
-  // not found so return nothing 
-  return nullptr; 
+  if(candidate != nullptr && !comp_(candidate->getKey(), key)){
+    return candidate; // neither is less than the other so the keys match 
+  }
+  return nullptr;
+}
+
+/**
+* The strict weak ordering descent for arithmetic keys, written so that
+* both selects compile to conditional moves. Links are read directly to
+* skip the virtual getters.
+*/
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::descend(const K& key, Node<Key, Value>*& parent, bool& isLeft, BranchlessDescent) const
+{
+  Node<Key, Value>* temp = root_; // start temp at the root
+  Node<Key, Value>* candidate = nullptr; // last node that key was not less than
+  parent = nullptr;
+  isLeft = false;
+
+  while(temp != nullptr){
+#if defined(__GNUC__)
+    // whichever way we go, the next node's key starts loading now
+    __builtin_prefetch(temp->left_);
+    __builtin_prefetch(temp->right_);
+#endif
+    parent = temp;
+    isLeft = comp_(key, temp->item_.first);
+    candidate = isLeft ? candidate : temp;
+    temp = isLeft ? temp->left_ : temp->right_;
+  }
+
+  if(candidate != nullptr && !comp_(candidate->item_.first, key)){
+    return candidate;
+  }
+  return nullptr;
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+int BinarySearchTree<Key, Value, Compare>::compareKeys(const K& key, const Key& nodeKey) const
+{
+  return compareKeys(key, nodeKey,
+      std::integral_constant<bool, HasThreeWayCompare<Compare, K, Key>::value>());
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+int BinarySearchTree<Key, Value, Compare>::compareKeys(const K& key, const Key& nodeKey, std::true_type) const
+{
+  return comp_.compare(key, nodeKey);
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+int BinarySearchTree<Key, Value, Compare>::compareKeys(const K& key, const Key& nodeKey, std::false_type) const
+{
+  if(comp_(key, nodeKey)){
+    return -1;
+  }
+  return comp_(nodeKey, key) ? 1 : 0;
+}
+
+template<typename Key, typename Value, typename Compare>
+template<typename K>
+Node<Key, Value>* BinarySearchTree<Key, Value, Compare>::lowerBoundNode(const K& key) const
+{
+  Node<Key, Value>* temp = root_; // start temp at the root
+  Node<Key, Value>* result = nullptr; // smallest node seen so far that is >= key
+
+  while(temp != nullptr){
+    if(comp_(temp->getKey(), key)){
+      temp = temp->getRight(); // too small so the answer is to the right 
+    }
+    else{
+      result = temp;
+      temp = temp->getLeft(); // might be an even smaller one to the left 
+    }
+  }
+  return result;
 }
 
 /**
  * Return true iff the BST is balanced.
  */
-template<typename Key, typename Value>
-bool BinarySearchTree<Key, Value>::isBalanced() const
+template<typename Key, typename Value, typename Compare>
+bool BinarySearchTree<Key, Value, Compare>::isBalanced() const
 {
     // TODO
 
@@ -799,8 +2184,8 @@ bool BinarySearchTree<Key, Value>::isBalanced() const
       return true;
 }
 
-template<typename Key, typename Value>
-int BinarySearchTree<Key, Value>::helpBalance(Node<Key, Value>* n) const{
+template<typename Key, typename Value, typename Compare>
+int BinarySearchTree<Key, Value, Compare>::helpBalance(Node<Key, Value>* n) const{
 
   // base cases
   if(n == nullptr)
@@ -840,12 +2225,15 @@ int BinarySearchTree<Key, Value>::helpBalance(Node<Key, Value>* n) const{
   return -1; // if not returned by now just in case 
 }
 
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2)
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2)
 {
     if((n1 == n2) || (n1 == NULL) || (n2 == NULL) ) {
         return;
     }
+    // the nodes trade places, so they may trade being first or last too
+    if(n1 == leftmost_ || n2 == leftmost_) leftmost_ = NULL;
+    if(n1 == rightmost_ || n2 == rightmost_) rightmost_ = NULL;
     Node<Key, Value>* n1p = n1->getParent();
     Node<Key, Value>* n1r = n1->getRight();
     Node<Key, Value>* n1lt = n1->getLeft();
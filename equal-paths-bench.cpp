@@ -0,0 +1,196 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "equal-paths.h"
+#include "treeshape.h"
+#include "treeexport.h"
+using namespace std;
+
+// Usage: ./equal-paths-bench [shape] [n]
+// Runs every shape when none is named.
+
+class BenchTimer
+{
+public:
+    BenchTimer() : start_(chrono::steady_clock::now()) {}
+    double seconds() const
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - start_).count();
+    }
+private:
+    chrono::steady_clock::time_point start_;
+};
+
+/**
+* Times equalPaths over a tree of n nodes, repeating until at least a
+* quarter second has gone by so the small early-exit cases still give a
+* stable number.
+*/
+static void report(const string& name, Node* root, size_t n)
+{
+    bool result = equalPaths(root);
+    size_t reps = 0;
+    BenchTimer timer;
+    do {
+        if(equalPaths(root) != result) {
+            cout << name << ": result changed between runs" << endl;
+            exit(1);
+        }
+        ++reps;
+    } while(timer.seconds() < 0.25);
+    cout << left << setw(36) << name << right << setw(10) << fixed << setprecision(2)
+         << (timer.seconds() * 1e3 / reps) << " ms/call  "
+         << setw(6) << setprecision(2) << (timer.seconds() * 1e9 / reps / n) << " ns/node  "
+         << (result ? "true" : "false") << endl;
+}
+
+/**
+* Times treeShape over the same tree, serially and split across every
+* hardware thread.
+*/
+static void reportShape(const string& name, Node* root, size_t n)
+{
+    unsigned threadCounts[] = {1, 0};
+    for(unsigned threads : threadCounts) {
+        TreeShape shape;
+        size_t reps = 0;
+        BenchTimer timer;
+        do {
+            shape = treeShape(root, threads);
+            ++reps;
+        } while(timer.seconds() < 0.25);
+        string label = name + (threads == 1 ? " shape" : " shape, all threads");
+        cout << left << setw(36) << label << right << setw(10) << fixed << setprecision(2)
+             << (timer.seconds() * 1e3 / reps) << " ms/call  "
+             << setw(6) << setprecision(2) << (timer.seconds() * 1e9 / reps / n) << " ns/node  "
+             << "height " << shape.height << ", leaves " << shape.minLeafDepth << ".." << shape.maxLeafDepth << endl;
+    }
+}
+
+/**
+* Times a full DOT and JSON export into a stream that discards its
+* output, so only the walk and the formatting are measured.
+*/
+static void reportExport(const string& name, Node* root, size_t n)
+{
+    struct NullBuffer : public streambuf
+    {
+        int overflow(int c) { return c; }
+        streamsize xsputn(const char*, streamsize count) { return count; }
+    } sink;
+    ostream out(&sink);
+    TreeExportFormat formats[] = {TREE_DOT, TREE_JSON};
+    for(TreeExportFormat format : formats) {
+        BenchTimer timer;
+        exportTree(out, root, format);
+        double seconds = timer.seconds();
+        cout << left << setw(36) << (name + (format == TREE_DOT ? " export DOT" : " export JSON"))
+             << right << setw(10) << fixed << setprecision(2) << (seconds * 1e3) << " ms/call  "
+             << setw(6) << setprecision(2) << (seconds * 1e9 / n) << " ns/node" << endl;
+    }
+}
+
+// Nodes live in one vector so building and freeing a million of them
+// doesn't need recursion either.
+
+static Node* buildComplete(vector<Node>& pool, size_t n)
+{
+    pool.clear();
+    pool.reserve(n);
+    for(size_t i = 0; i < n; i++) {
+        pool.push_back(Node((int)i));
+    }
+    for(size_t i = 0; i < n; i++) {
+        if(2 * i + 1 < n) pool[i].left = &pool[2 * i + 1];
+        if(2 * i + 2 < n) pool[i].right = &pool[2 * i + 2];
+    }
+    return n ? &pool[0] : nullptr;
+}
+
+static Node* buildRandom(vector<Node>& pool, size_t n)
+{
+    mt19937 rng(42);
+    pool.clear();
+    pool.reserve(n);
+    for(size_t i = 0; i < n; i++) {
+        pool.push_back(Node((int)rng()));
+        if(i == 0) continue;
+        Node* cur = &pool[0];
+        while(true) {
+            Node*& next = (pool[i].key < cur->key) ? cur->left : cur->right;
+            if(next == nullptr) {
+                next = &pool[i];
+                break;
+            }
+            cur = next;
+        }
+    }
+    return n ? &pool[0] : nullptr;
+}
+
+// A single zig-zag chain: one leaf, n - 1 levels deep.
+static Node* buildPath(vector<Node>& pool, size_t n)
+{
+    pool.clear();
+    pool.reserve(n);
+    for(size_t i = 0; i < n; i++) {
+        pool.push_back(Node((int)i));
+    }
+    for(size_t i = 0; i + 1 < n; i++) {
+        if(i % 2) pool[i].left = &pool[i + 1];
+        else pool[i].right = &pool[i + 1];
+    }
+    return n ? &pool[0] : nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+    string shape = (argc > 1) ? argv[1] : "all";
+    size_t n = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    bool all = (shape == "all");
+    bool ran = false;
+    vector<Node> pool;
+    if(all || shape == "complete") {
+        // Unless n is 2^k - 1 the array layout leaves some leaves a level
+        // short, so trim n to a perfect tree first.
+        size_t perfect = 1;
+        while(perfect * 2 + 1 <= n) perfect = perfect * 2 + 1;
+        Node* root = buildComplete(pool, perfect);
+        report("complete (" + to_string(perfect) + " nodes)", root, perfect);
+        reportShape("complete", root, perfect);
+        reportExport("complete", root, perfect);
+        // One extra leaf under the last node: the whole tree is walked
+        // before the mismatch shows up.
+        Node* last = root;
+        while(last->right) last = last->right;
+        Node extra(-1);
+        last->right = &extra;
+        report("complete + late mismatch", root, perfect + 1);
+        last->right = nullptr;
+        ran = true;
+    }
+    if(all || shape == "random") {
+        Node* root = buildRandom(pool, n);
+        report("random (" + to_string(n) + " nodes)", root, n);
+        reportShape("random", root, n);
+        reportExport("random", root, n);
+        ran = true;
+    }
+    if(all || shape == "path") {
+        Node* root = buildPath(pool, n);
+        report("path (" + to_string(n) + " nodes)", root, n);
+        reportShape("path", root, n);
+        reportExport("path", root, n);
+        ran = true;
+    }
+    if(!ran) {
+        cout << "Unknown shape " << shape << "; expected complete, random or path" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 #ifndef RECCHECK
 //if you want to add any #includes like <iostream> you must do them here (before the next endif)
 #include <iostream>
+#include <vector>
 #endif
 
 #include "equal-paths.h"
@@ -8,71 +9,64 @@ using namespace std;
 
 
 // You may add any prototypes of helper functions here
-int helperFunc(Node* n); // helper function to recurse down the tree until finds a leaf --> returns level in number
+
+// a node still to visit and how far below the root it sits
+struct PendingNode {
+  Node* node;
+  int depth;
+};
 
 bool equalPaths(Node * root)
 {
   // Add your code below
 
-  // base case: 
-  if( root == nullptr){
-      return true; // equal distance 
+  // walks the tree once, depth first and left first, keeping our own stack
+  // so a million-level chain can't overflow the call stack
+  if(root == nullptr){
+    return true; // equal distance
   }
 
-  // if found a leaf, return true
-  if(root->left == nullptr && root->right == nullptr){
-      return true;
-  }
+  vector<PendingNode> pending; // right children we still have to come back for
+  pending.reserve(64);
+  Node* cur = root;
+  int depth = 0;
+  int leafDepth = -1; // depth of the first leaf found, -1 until then
 
-  // if the depth of the left and right sides are not equal, return false!
-  if(helperFunc(root->right) != helperFunc(root->left)){ // get depth of right and left and compare
-      return false;
-  }
-  else{ // else they are equal so continue  through the tree 
-    
-    // recurse down the tree
-    bool rightSide = equalPaths(root->right); // rightSide returns true if rightSide's nodes are all equal depth
-    bool leftSide = equalPaths(root->left); // lefttSide returns true if lefttSide's nodes are all equal depth
-  
-    // if both sides true, then equal depth and good to return true 
-    if(rightSide == true && leftSide == true){
-      return true;
+  while(true){
+    // if found a leaf, it has to match the first one
+    if(cur->left == nullptr && cur->right == nullptr){
+      if(leafDepth < 0){
+        leafDepth = depth;
+      }
+      else if(depth != leafDepth){
+        return false;
+      }
+      if(pending.empty()){
+        break;
+      }
+      cur = pending.back().node;
+      depth = pending.back().depth;
+      pending.pop_back();
+      continue;
     }
-    else{
+
+    // a node with kids at or below the first leaf's depth can only lead to deeper leaves
+    if(leafDepth >= 0 && depth >= leafDepth){
       return false;
     }
-  }
-
-  return false; // if not caught before
 
-}
-
-// recurses down the tree until leaf and returns the depth as an int 
-int helperFunc(Node* n){
-  
-  // base case 
-  if(n == nullptr){
-    return 0; // depth is zero
-  }
-
-  // if no kids
-  if(n->left == nullptr && n->right == nullptr){
-    return 0; // + 0 because no kids 
-  }
-
-  // if has only a right kid 
-  if(n->left == nullptr){
-    return helperFunc(n->right) + 1; // + 1 because 1 kid 
-  }
-
-  // if has only a left kid 
-  if(n->right == nullptr){
-    return helperFunc(n->left) + 1; // + 1 because 1 kid 
-  }
-
-  // if has both kids 
-  if(n->left != nullptr && n->right != nullptr){
-    return helperFunc(n->left) + 1; // + 1 because a kid and just choose a path to go down, doesn't matter
+    // go left (or right if there is no left) and save the right kid for later
+    depth++;
+    if(cur->left == nullptr){
+      cur = cur->right;
+    }
+    else{
+      if(cur->right != nullptr){
+        pending.push_back(PendingNode{cur->right, depth});
+      }
+      cur = cur->left;
+    }
   }
 
+  return true; // every leaf matched the first
 }
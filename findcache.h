@@ -0,0 +1,211 @@
+#ifndef FINDCACHE_H
+#define FINDCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* How a find cache has done since it was turned on
+*/
+struct FindCacheStats
+{
+    FindCacheStats() : hits(0), misses(0), slots(0) {}
+
+    size_t hits;
+    size_t misses;
+    size_t slots;
+
+    double hitRate() const
+    {
+        return (hits + misses == 0) ? 0.0 : double(hits) / double(hits + misses);
+    }
+};
+
+/**
+* A small two-way set-associative cache from keys to the nodes holding
+* them. Entries keep the key's full hash next to the node, so a probe
+* only touches a node whose hash matches, and the caller then confirms
+* the key with its own comparator. Within a set the most recently found
+* node sits in the first way.
+*
+* The cache never owns a node: the tree tells it when a node is freed
+* or moved, and resets it when the tree is cleared.
+*/
+template<typename Key, typename NodeT>
+class FindCache
+{
+public:
+    typedef size_t (*HashFn)(const Key&);
+
+    // Rounds slots up to a power of two, and at least one set
+    FindCache(size_t slots, HashFn hash);
+    // The same shape and hash as other, but empty
+    FindCache(const FindCache& other);
+
+    size_t hash(const Key& key) const;
+    // The cached node with hash h that same() accepts, or NULL; counts a
+    // hit or a miss either way.
+    template<typename Same>
+    NodeT* find(size_t h, Same same);
+    void insert(size_t h, NodeT* n);
+    // n, holding key, is about to be freed or has moved to to
+    void forget(const Key& key, const NodeT* n);
+    void moved(const Key& key, const NodeT* from, NodeT* to);
+    // Drops every entry, keeping the counts
+    void reset();
+
+    FindCacheStats stats() const;
+
+private:
+    FindCache& operator=(const FindCache&);
+
+    static const size_t ways = 2;
+
+    struct Entry
+    {
+        size_t hash;
+        NodeT* node;
+    };
+
+    // First entry of the set for hash h
+    Entry* set(size_t h);
+
+    std::vector<Entry> entries_;
+    size_t setMask_;
+    HashFn hash_;
+    size_t hits_;
+    size_t misses_;
+};
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the FindCache class.
+  ----------------------------------------------------
+*/
+
+template<typename Key, typename NodeT>
+FindCache<Key, NodeT>::FindCache(size_t slots, HashFn hash) :
+    setMask_(0), hash_(hash), hits_(0), misses_(0)
+{
+    size_t sets = 1;
+    while(sets * ways < slots) {
+        sets *= 2;
+    }
+    Entry empty = { 0, NULL };
+    entries_.assign(sets * ways, empty);
+    setMask_ = sets - 1;
+}
+
+template<typename Key, typename NodeT>
+FindCache<Key, NodeT>::FindCache(const FindCache& other) :
+    setMask_(other.setMask_), hash_(other.hash_), hits_(0), misses_(0)
+{
+    Entry empty = { 0, NULL };
+    entries_.assign(other.entries_.size(), empty);
+}
+
+template<typename Key, typename NodeT>
+size_t FindCache<Key, NodeT>::hash(const Key& key) const
+{
+    return hash_(key);
+}
+
+/**
+* Standard hashes of integers are the identity, so the set comes from
+* the high half of a Fibonacci multiply: consecutive keys then spread
+* over every set instead of landing in neighbouring ones.
+*/
+template<typename Key, typename NodeT>
+typename FindCache<Key, NodeT>::Entry* FindCache<Key, NodeT>::set(size_t h)
+{
+    uint64_t mixed = uint64_t(h) * 0x9E3779B97F4A7C15ull;
+    return &entries_[(size_t(mixed >> 32) & setMask_) * ways];
+}
+
+template<typename Key, typename NodeT>
+template<typename Same>
+NodeT* FindCache<Key, NodeT>::find(size_t h, Same same)
+{
+    Entry* s = set(h);
+    for(size_t i = 0; i < ways; ++i) {
+        if(s[i].node != NULL && s[i].hash == h && same(s[i].node)) {
+            NodeT* n = s[i].node;
+            for(; i > 0; --i) {
+                s[i] = s[i - 1];
+            }
+            s[0].hash = h;
+            s[0].node = n;
+            ++hits_;
+            return n;
+        }
+    }
+    ++misses_;
+    return NULL;
+}
+
+/**
+* A new node takes a free way or else the last one, and only moves up
+* once it is found again. A burst of one-off keys then just takes turns
+* in the last way, and the node in the first way, found at least twice,
+* stays put.
+*/
+template<typename Key, typename NodeT>
+void FindCache<Key, NodeT>::insert(size_t h, NodeT* n)
+{
+    Entry* s = set(h);
+    size_t i = 0;
+    while(i < ways - 1 && s[i].node != NULL) {
+        ++i;
+    }
+    s[i].hash = h;
+    s[i].node = n;
+}
+
+template<typename Key, typename NodeT>
+void FindCache<Key, NodeT>::forget(const Key& key, const NodeT* n)
+{
+    Entry* s = set(hash_(key));
+    for(size_t i = 0; i < ways; ++i) {
+        if(s[i].node == n) {
+            s[i].node = NULL;
+        }
+    }
+}
+
+template<typename Key, typename NodeT>
+void FindCache<Key, NodeT>::moved(const Key& key, const NodeT* from, NodeT* to)
+{
+    Entry* s = set(hash_(key));
+    for(size_t i = 0; i < ways; ++i) {
+        if(s[i].node == from) {
+            s[i].node = to;
+        }
+    }
+}
+
+template<typename Key, typename NodeT>
+void FindCache<Key, NodeT>::reset()
+{
+    for(size_t i = 0; i < entries_.size(); ++i) {
+        entries_[i].node = NULL;
+    }
+}
+
+template<typename Key, typename NodeT>
+FindCacheStats FindCache<Key, NodeT>::stats() const
+{
+    FindCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.slots = entries_.size();
+    return stats;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the FindCache class.
+  ----------------------------------------------------
+*/
+
+#endif
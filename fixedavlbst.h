@@ -0,0 +1,563 @@
+#ifndef FIXEDAVLBST_H
+#define FIXEDAVLBST_H
+
+#include <cstddef>
+#include <climits>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#if __cplusplus < 201402L
+#error "fixedavlbst.h needs C++14 or later for its constexpr members"
+#endif
+
+/**
+* An AVL tree with room for at most N items, stored in an array inside
+* the tree object, so it never touches the heap. Nodes link to each other
+* by index, and freed slots are reused. Every member is constexpr, so a
+* tree of literal keys and values can be built and searched at compile
+* time:
+*
+*     constexpr FixedAVLTree<int, char, 4> grades = {{90, 'A'}, {80, 'B'}};
+*     static_assert(grades.contains(80), "");
+*
+* find/insert/remove/operator[] and iteration work as in AVLTree, with two
+* differences. Iterators give read-only items, since a constexpr tree is
+* const; change a value with operator[] or insert. And insert throws
+* std::length_error when a new key doesn't fit, which is a compile error
+* in a constant expression.
+*/
+template <class Key, class Value, size_t N, class Compare = std::less<Key> >
+class FixedAVLTree
+{
+    static_assert(N > 0, "FixedAVLTree needs room for at least one item");
+    static_assert(N < (size_t)INT_MAX, "FixedAVLTree indexes nodes with int");
+
+public:
+    typedef std::pair<Key, Value> value_type;
+
+    constexpr FixedAVLTree();
+    constexpr explicit FixedAVLTree(const Compare& comp);
+    constexpr FixedAVLTree(std::initializer_list<value_type> items);
+
+    constexpr void insert(const std::pair<const Key, Value>& new_item);
+    constexpr void remove(const Key& key);
+    constexpr void clear();
+    constexpr bool empty() const;
+    constexpr size_t size() const;
+    constexpr size_t capacity() const;
+
+    /**
+    * Walks the items in key order.
+    */
+    class iterator
+    {
+    public:
+        constexpr iterator();
+
+        constexpr const value_type& operator*() const;
+        constexpr const value_type* operator->() const;
+
+        constexpr bool operator==(const iterator& rhs) const;
+        constexpr bool operator!=(const iterator& rhs) const;
+
+        constexpr iterator& operator++();
+
+    protected:
+        friend class FixedAVLTree<Key, Value, N, Compare>;
+        constexpr iterator(const FixedAVLTree* tree, int index);
+        const FixedAVLTree* tree_;
+        int index_;
+    };
+
+    constexpr iterator begin() const;
+    constexpr iterator end() const;
+    constexpr iterator find(const Key& key) const;
+    constexpr size_t count(const Key& key) const;
+    constexpr bool contains(const Key& key) const;
+    constexpr Value& operator[](const Key& key);
+    constexpr Value const & operator[](const Key& key) const;
+
+protected:
+    static constexpr int NIL = -1;
+
+    struct Slot
+    {
+        constexpr Slot() : item(), parent(NIL), left(NIL), right(NIL), height(0) { }
+
+        value_type item;
+        int parent;
+        int left;
+        int right;      // next free slot while the slot is unused
+        int height;
+    };
+
+    // Returns the slot holding key, or NIL
+    constexpr int findSlot(const Key& key) const;
+    // Takes a slot from the free list, or the next never-used one
+    constexpr int allocate();
+    constexpr void release(int i);
+
+    constexpr int height(int i) const;
+    constexpr void updateHeight(int i);
+    // Puts v (maybe NIL) where u hangs from its parent
+    constexpr void transplant(int u, int v);
+    constexpr int rotateLeft(int x);
+    constexpr int rotateRight(int x);
+    // Fixes heights and balance from i up to the root
+    constexpr void rebalanceUp(int i);
+
+    Slot slots_[N];
+    int root_;
+    int freeHead_;
+    size_t used_;       // slots below this have been handed out at least once
+    size_t size_;
+    Compare comp_;
+};
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr int FixedAVLTree<Key, Value, N, Compare>::NIL;
+
+/*
+  ---------------------------------------------------------
+  Begin implementations for the FixedAVLTree::iterator class.
+  ---------------------------------------------------------
+*/
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr FixedAVLTree<Key, Value, N, Compare>::iterator::iterator() : tree_(nullptr), index_(NIL)
+{
+
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr FixedAVLTree<Key, Value, N, Compare>::iterator::iterator(const FixedAVLTree* tree, int index) :
+    tree_(tree), index_(index)
+{
+
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr const typename FixedAVLTree<Key, Value, N, Compare>::value_type&
+FixedAVLTree<Key, Value, N, Compare>::iterator::operator*() const
+{
+    return tree_->slots_[index_].item;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr const typename FixedAVLTree<Key, Value, N, Compare>::value_type*
+FixedAVLTree<Key, Value, N, Compare>::iterator::operator->() const
+{
+    return &(tree_->slots_[index_].item);
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr bool FixedAVLTree<Key, Value, N, Compare>::iterator::operator==(const iterator& rhs) const
+{
+    return index_ == rhs.index_;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr bool FixedAVLTree<Key, Value, N, Compare>::iterator::operator!=(const iterator& rhs) const
+{
+    return index_ != rhs.index_;
+}
+
+/**
+* Moves to the leftmost node of the right subtree, or else up to the
+* first ancestor we are left of.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr typename FixedAVLTree<Key, Value, N, Compare>::iterator&
+FixedAVLTree<Key, Value, N, Compare>::iterator::operator++()
+{
+    const Slot* s = tree_->slots_;
+    int i = index_;
+    if(s[i].right != NIL) {
+        i = s[i].right;
+        while(s[i].left != NIL) {
+            i = s[i].left;
+        }
+    }
+    else {
+        int p = s[i].parent;
+        while(p != NIL && i == s[p].right) {
+            i = p;
+            p = s[p].parent;
+        }
+        i = p;
+    }
+    index_ = i;
+    return *this;
+}
+
+/*
+  -------------------------------------------------------
+  End implementations for the FixedAVLTree::iterator class.
+  -------------------------------------------------------
+*/
+
+/*
+  -----------------------------------------------
+  Begin implementations for the FixedAVLTree class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr FixedAVLTree<Key, Value, N, Compare>::FixedAVLTree() :
+    slots_(), root_(NIL), freeHead_(NIL), used_(0), size_(0), comp_()
+{
+
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr FixedAVLTree<Key, Value, N, Compare>::FixedAVLTree(const Compare& comp) :
+    slots_(), root_(NIL), freeHead_(NIL), used_(0), size_(0), comp_(comp)
+{
+
+}
+
+/**
+* Inserts the items in order; a repeated key keeps the last value.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr FixedAVLTree<Key, Value, N, Compare>::FixedAVLTree(std::initializer_list<value_type> items) :
+    slots_(), root_(NIL), freeHead_(NIL), used_(0), size_(0), comp_()
+{
+    for(const value_type* it = items.begin(); it != items.end(); ++it) {
+        insert(std::pair<const Key, Value>(it->first, it->second));
+    }
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr int FixedAVLTree<Key, Value, N, Compare>::findSlot(const Key& key) const
+{
+    int i = root_;
+    while(i != NIL) {
+        if(comp_(key, slots_[i].item.first)) {
+            i = slots_[i].left;
+        }
+        else if(comp_(slots_[i].item.first, key)) {
+            i = slots_[i].right;
+        }
+        else {
+            return i;
+        }
+    }
+    return NIL;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr int FixedAVLTree<Key, Value, N, Compare>::allocate()
+{
+    if(freeHead_ != NIL) {
+        int i = freeHead_;
+        freeHead_ = slots_[i].right;
+        return i;
+    }
+    if(used_ == N) {
+        throw std::length_error("FixedAVLTree is full");
+    }
+    return (int)used_++;
+}
+
+/**
+* Resets the item so a freed slot doesn't hold on to what it owned.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::release(int i)
+{
+    slots_[i].item.first = Key();
+    slots_[i].item.second = Value();
+    slots_[i].parent = NIL;
+    slots_[i].left = NIL;
+    slots_[i].right = freeHead_;
+    freeHead_ = i;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr int FixedAVLTree<Key, Value, N, Compare>::height(int i) const
+{
+    return (i == NIL) ? 0 : slots_[i].height;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::updateHeight(int i)
+{
+    int l = height(slots_[i].left);
+    int r = height(slots_[i].right);
+    slots_[i].height = 1 + ((l < r) ? r : l);
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::transplant(int u, int v)
+{
+    int p = slots_[u].parent;
+    if(p == NIL) {
+        root_ = v;
+    }
+    else if(slots_[p].left == u) {
+        slots_[p].left = v;
+    }
+    else {
+        slots_[p].right = v;
+    }
+    if(v != NIL) {
+        slots_[v].parent = p;
+    }
+}
+
+/**
+* Lifts x's right child into x's place and returns it.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr int FixedAVLTree<Key, Value, N, Compare>::rotateLeft(int x)
+{
+    int y = slots_[x].right;
+    transplant(x, y);
+    slots_[x].right = slots_[y].left;
+    if(slots_[y].left != NIL) {
+        slots_[slots_[y].left].parent = x;
+    }
+    slots_[y].left = x;
+    slots_[x].parent = y;
+    updateHeight(x);
+    updateHeight(y);
+    return y;
+}
+
+/**
+* Lifts x's left child into x's place and returns it.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr int FixedAVLTree<Key, Value, N, Compare>::rotateRight(int x)
+{
+    int y = slots_[x].left;
+    transplant(x, y);
+    slots_[x].left = slots_[y].right;
+    if(slots_[y].right != NIL) {
+        slots_[slots_[y].right].parent = x;
+    }
+    slots_[y].right = x;
+    slots_[x].parent = y;
+    updateHeight(x);
+    updateHeight(y);
+    return y;
+}
+
+/**
+* Heights are stored rather than balances, so insert and remove share
+* this one walk: recompute each height on the way up and rotate wherever
+* the two sides differ by two.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::rebalanceUp(int i)
+{
+    while(i != NIL) {
+        updateHeight(i);
+        int balance = height(slots_[i].left) - height(slots_[i].right);
+        if(balance > 1) {
+            int l = slots_[i].left;
+            if(height(slots_[l].left) < height(slots_[l].right)) {
+                rotateLeft(l);
+            }
+            i = rotateRight(i);
+        }
+        else if(balance < -1) {
+            int r = slots_[i].right;
+            if(height(slots_[r].right) < height(slots_[r].left)) {
+                rotateRight(r);
+            }
+            i = rotateLeft(i);
+        }
+        i = slots_[i].parent;
+    }
+}
+
+/**
+* Adds the item, or overwrites the value if the key is already present.
+* Throws std::length_error if the key is new and the tree is full.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::insert(const std::pair<const Key, Value>& new_item)
+{
+    int parent = NIL;
+    bool goLeft = false;
+    for(int i = root_; i != NIL; ) {
+        if(comp_(new_item.first, slots_[i].item.first)) {
+            goLeft = true;
+        }
+        else if(comp_(slots_[i].item.first, new_item.first)) {
+            goLeft = false;
+        }
+        else {
+            slots_[i].item.second = new_item.second;
+            return;
+        }
+        parent = i;
+        i = goLeft ? slots_[i].left : slots_[i].right;
+    }
+
+    int n = allocate();
+    slots_[n].item.first = new_item.first;
+    slots_[n].item.second = new_item.second;
+    slots_[n].parent = parent;
+    slots_[n].left = NIL;
+    slots_[n].right = NIL;
+    slots_[n].height = 1;
+    ++size_;
+    if(parent == NIL) {
+        root_ = n;
+        return;
+    }
+    if(goLeft) {
+        slots_[parent].left = n;
+    }
+    else {
+        slots_[parent].right = n;
+    }
+    rebalanceUp(parent);
+}
+
+/**
+* Removes the key if present. A node with two children is replaced by its
+* predecessor's node rather than by a copy of its item, so iterators to
+* the other items stay valid.
+*/
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::remove(const Key& key)
+{
+    int z = findSlot(key);
+    if(z == NIL) {
+        return;
+    }
+
+    int start = slots_[z].parent;   // lowest node whose subtree changed
+    if(slots_[z].left != NIL && slots_[z].right != NIL) {
+        int p = slots_[z].left;
+        while(slots_[p].right != NIL) {
+            p = slots_[p].right;
+        }
+        if(slots_[p].parent == z) {
+            start = p;
+        }
+        else {
+            start = slots_[p].parent;
+            transplant(p, slots_[p].left);
+            slots_[p].left = slots_[z].left;
+            slots_[slots_[p].left].parent = p;
+        }
+        transplant(z, p);
+        slots_[p].right = slots_[z].right;
+        slots_[slots_[p].right].parent = p;
+        slots_[p].height = slots_[z].height;
+    }
+    else {
+        transplant(z, (slots_[z].left != NIL) ? slots_[z].left : slots_[z].right);
+    }
+
+    release(z);
+    --size_;
+    rebalanceUp(start);
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr void FixedAVLTree<Key, Value, N, Compare>::clear()
+{
+    for(size_t i = 0; i < used_; ++i) {
+        slots_[i].item.first = Key();
+        slots_[i].item.second = Value();
+        slots_[i].parent = NIL;
+        slots_[i].left = NIL;
+        slots_[i].right = NIL;
+        slots_[i].height = 0;
+    }
+    root_ = NIL;
+    freeHead_ = NIL;
+    used_ = 0;
+    size_ = 0;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr bool FixedAVLTree<Key, Value, N, Compare>::empty() const
+{
+    return root_ == NIL;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr size_t FixedAVLTree<Key, Value, N, Compare>::size() const
+{
+    return size_;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr size_t FixedAVLTree<Key, Value, N, Compare>::capacity() const
+{
+    return N;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr typename FixedAVLTree<Key, Value, N, Compare>::iterator
+FixedAVLTree<Key, Value, N, Compare>::begin() const
+{
+    int i = root_;
+    while(i != NIL && slots_[i].left != NIL) {
+        i = slots_[i].left;
+    }
+    return iterator(this, i);
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr typename FixedAVLTree<Key, Value, N, Compare>::iterator
+FixedAVLTree<Key, Value, N, Compare>::end() const
+{
+    return iterator(this, NIL);
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr typename FixedAVLTree<Key, Value, N, Compare>::iterator
+FixedAVLTree<Key, Value, N, Compare>::find(const Key& key) const
+{
+    return iterator(this, findSlot(key));
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr size_t FixedAVLTree<Key, Value, N, Compare>::count(const Key& key) const
+{
+    return (findSlot(key) == NIL) ? 0 : 1;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr bool FixedAVLTree<Key, Value, N, Compare>::contains(const Key& key) const
+{
+    return findSlot(key) != NIL;
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value, size_t N, class Compare>
+constexpr Value& FixedAVLTree<Key, Value, N, Compare>::operator[](const Key& key)
+{
+    int i = findSlot(key);
+    if(i == NIL) throw std::out_of_range("Invalid key");
+    return slots_[i].item.second;
+}
+
+template<class Key, class Value, size_t N, class Compare>
+constexpr Value const & FixedAVLTree<Key, Value, N, Compare>::operator[](const Key& key) const
+{
+    int i = findSlot(key);
+    if(i == NIL) throw std::out_of_range("Invalid key");
+    return slots_[i].item.second;
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the FixedAVLTree class.
+  ---------------------------------------------
+*/
+
+#endif
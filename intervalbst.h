@@ -0,0 +1,173 @@
+#ifndef INTERVALBST_H
+#define INTERVALBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "augmentedbst.h"
+
+/**
+* Largest interval end in a subtree. Keys are (start, end) pairs.
+*/
+template <typename Point, typename Value>
+struct MaxEndMonoid
+{
+    typedef Point value_type;
+    Point identity() const { return std::numeric_limits<Point>::lowest(); }
+    Point lift(const std::pair<Point, Point>& interval, const Value&) const { return interval.second; }
+    Point combine(const Point& a, const Point& b) const { return (a < b) ? b : a; }
+};
+
+/**
+* A map from half-open intervals [start, end) to values. Intervals are
+* ordered by start, then end, so many intervals can share a start; an
+* identical interval overwrites the value like any other key.
+*
+* Every node keeps the largest end in its subtree, maintained through
+* rotations and removals by AugmentedAVLTree. A query skips any subtree
+* whose largest end is not past the query start, and stops going right
+* once starts pass the query end. Hits can sit far apart in the tree,
+* each needing a descent of its own, so k hits cost
+* O(min(n, (k + 1) log n)), not O(log n + k). Hits are reported in key
+* order.
+*
+* Point needs operator< and std::numeric_limits.
+*/
+template <class Point, class Value>
+class IntervalTree : public AugmentedAVLTree<std::pair<Point, Point>, Value, MaxEndMonoid<Point, Value> >
+{
+public:
+    typedef std::pair<Point, Point> interval_type;
+    typedef AugmentedAVLTree<interval_type, Value, MaxEndMonoid<Point, Value> > base_type;
+    typedef typename base_type::iterator iterator;
+
+    IntervalTree();
+
+    void insert(const Point& start, const Point& end, const Value& value);
+    void remove(const Point& start, const Point& end);
+    using base_type::insert;
+    using base_type::remove;
+
+    // Calls f(item) for every interval containing p
+    template<typename Func>
+    void forEachStabbing(const Point& p, Func f) const;
+    // Calls f(item) for every interval overlapping [lo, hi)
+    template<typename Func>
+    void forEachOverlapping(const Point& lo, const Point& hi, Func f) const;
+
+    // Same queries, collecting iterators to the hits
+    std::vector<iterator> stab(const Point& p) const;
+    std::vector<iterator> overlapping(const Point& lo, const Point& hi) const;
+
+protected:
+    // Calls f(node) for the intervals in n's subtree that end after lo
+    // and start before hi, or at hi too when closedHi is set.
+    template<typename Func>
+    void search(Node<interval_type, Value>* n, const Point& lo, const Point& hi, bool closedHi, Func& f) const;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the IntervalTree class.
+  -----------------------------------------------
+*/
+
+template<class Point, class Value>
+IntervalTree<Point, Value>::IntervalTree() : base_type()
+{
+
+}
+
+/**
+* Adds [start, end) with the given value, or overwrites the value if
+* that exact interval is already stored.
+*/
+template<class Point, class Value>
+void IntervalTree<Point, Value>::insert(const Point& start, const Point& end, const Value& value)
+{
+    base_type::insert(std::make_pair(std::make_pair(start, end), value));
+}
+
+template<class Point, class Value>
+void IntervalTree<Point, Value>::remove(const Point& start, const Point& end)
+{
+    base_type::remove(std::make_pair(start, end));
+}
+
+template<class Point, class Value>
+template<typename Func>
+void IntervalTree<Point, Value>::search(Node<interval_type, Value>* n, const Point& lo, const Point& hi, bool closedHi, Func& f) const
+{
+    // nothing down here ends after lo
+    if(n == NULL || !(lo < this->subtreeAggregate(n))) {
+        return;
+    }
+    search(n->getLeft(), lo, hi, closedHi, f);
+
+    const Point& start = n->getKey().first;
+    bool startsInside = closedHi ? !(hi < start) : (start < hi);
+    if(!startsInside) {
+        return; // everything to the right starts even later
+    }
+    if(lo < n->getKey().second) {
+        f(n);
+    }
+    search(n->getRight(), lo, hi, closedHi, f);
+}
+
+/**
+* Reports every interval with start <= p < end.
+*/
+template<class Point, class Value>
+template<typename Func>
+void IntervalTree<Point, Value>::forEachStabbing(const Point& p, Func f) const
+{
+    auto visit = [&f](Node<interval_type, Value>* n) { f(n->getItem()); };
+    search(this->root_, p, p, true, visit);
+}
+
+/**
+* Reports every interval with start < hi and end > lo.
+*/
+template<class Point, class Value>
+template<typename Func>
+void IntervalTree<Point, Value>::forEachOverlapping(const Point& lo, const Point& hi, Func f) const
+{
+    if(lo < hi) {
+        auto visit = [&f](Node<interval_type, Value>* n) { f(n->getItem()); };
+        search(this->root_, lo, hi, false, visit);
+    }
+}
+
+template<class Point, class Value>
+std::vector<typename IntervalTree<Point, Value>::iterator>
+IntervalTree<Point, Value>::stab(const Point& p) const
+{
+    std::vector<iterator> hits;
+    auto collect = [this, &hits](Node<interval_type, Value>* n) { hits.push_back(this->iteratorAt(n)); };
+    search(this->root_, p, p, true, collect);
+    return hits;
+}
+
+template<class Point, class Value>
+std::vector<typename IntervalTree<Point, Value>::iterator>
+IntervalTree<Point, Value>::overlapping(const Point& lo, const Point& hi) const
+{
+    std::vector<iterator> hits;
+    if(lo < hi) {
+        auto collect = [this, &hits](Node<interval_type, Value>* n) { hits.push_back(this->iteratorAt(n)); };
+        search(this->root_, lo, hi, false, collect);
+    }
+    return hits;
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the IntervalTree class.
+  ---------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,721 @@
+#ifndef INTRUSIVEBST_H
+#define INTRUSIVEBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+template <class T, class Key, class KeyOf, class Compare, class Tag>
+class IntrusiveAVLTree;
+
+/**
+* The links and balance an object needs to sit in an IntrusiveAVLTree.
+* A type joins a tree by deriving from IntrusiveAVLHook<itself>; give
+* each hook a different Tag type to put one object in several trees.
+*
+* Copying an object doesn't copy its place in a tree: the copy starts
+* unlinked, and assigning leaves the target's links alone.
+*/
+template <class T, class Tag = void>
+class IntrusiveAVLHook
+{
+public:
+    IntrusiveAVLHook();
+    IntrusiveAVLHook(const IntrusiveAVLHook& other);
+    IntrusiveAVLHook& operator=(const IntrusiveAVLHook& other);
+
+    bool isLinked() const;
+
+private:
+    template <class, class, class, class, class> friend class IntrusiveAVLTree;
+
+    T* parent_;
+    T* left_;
+    T* right_;
+    int8_t balance_;    // left height minus right height
+    bool linked_;
+};
+
+/*
+  ------------------------------------------------------
+  Begin implementations for the IntrusiveAVLHook class.
+  ------------------------------------------------------
+*/
+
+template<class T, class Tag>
+IntrusiveAVLHook<T, Tag>::IntrusiveAVLHook() :
+    parent_(NULL), left_(NULL), right_(NULL), balance_(0), linked_(false)
+{
+
+}
+
+template<class T, class Tag>
+IntrusiveAVLHook<T, Tag>::IntrusiveAVLHook(const IntrusiveAVLHook&) :
+    parent_(NULL), left_(NULL), right_(NULL), balance_(0), linked_(false)
+{
+
+}
+
+template<class T, class Tag>
+IntrusiveAVLHook<T, Tag>& IntrusiveAVLHook<T, Tag>::operator=(const IntrusiveAVLHook&)
+{
+    return *this;
+}
+
+/**
+* Returns true while the object is in a tree.
+*/
+template<class T, class Tag>
+bool IntrusiveAVLHook<T, Tag>::isLinked() const
+{
+    return linked_;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the IntrusiveAVLHook class.
+  ----------------------------------------------------
+*/
+
+/**
+* An AVL tree of objects the caller owns. Each object carries its own
+* links in an IntrusiveAVLHook base, so insert and remove only relink
+* the objects: nothing is allocated, copied or freed, and a lookup
+* lands on the object itself rather than on a node holding a copy.
+*
+* KeyOf maps an object to its key (const Key& operator()(const T&)),
+* and Compare orders the keys. Keys are unique; a key must not change
+* while its object is linked. The tree never deletes objects, and
+* clear() and the destructor just unlink them, so they can go straight
+* back to their pool.
+*/
+template <class T, class Key, class KeyOf, class Compare = std::less<Key>, class Tag = void>
+class IntrusiveAVLTree
+{
+public:
+    typedef IntrusiveAVLHook<T, Tag> hook_type;
+
+    IntrusiveAVLTree();
+    IntrusiveAVLTree(const KeyOf& keyOf, const Compare& comp);
+    // An object has room for one place per hook, so trees can't be copied
+    IntrusiveAVLTree(const IntrusiveAVLTree& other) = delete;
+    IntrusiveAVLTree& operator=(const IntrusiveAVLTree& other) = delete;
+    IntrusiveAVLTree(IntrusiveAVLTree&& other) noexcept;
+    IntrusiveAVLTree& operator=(IntrusiveAVLTree&& other) noexcept;
+    ~IntrusiveAVLTree();
+    void swap(IntrusiveAVLTree& other) noexcept;
+
+    /**
+    * Walks the linked objects in key order.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        T& operator*() const;
+        T* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>;
+        explicit iterator(T* ptr);
+        T* current_;
+    };
+
+    // Links obj; returns false and leaves the tree alone if an object
+    // with an equal key is already linked
+    bool insert(T& obj);
+    // Unlinks the object with the key and returns it, or NULL
+    T* remove(const Key& key);
+    // Unlinks an object known to be in this tree, without a search
+    void unlink(T& obj);
+    iterator erase(iterator pos);
+    // Unlinks every object
+    void clear();
+
+    bool empty() const;
+    size_t size() const;
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    size_t count(const Key& key) const;
+    bool contains(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
+    T& operator[](const Key& key) const;
+
+protected:
+    static hook_type& hook(T* n);
+    static T* successor(T* n);
+
+    const Key& keyOf(T* n) const;
+    T* findNode(const Key& key) const;
+
+    // Puts v (maybe NULL) where u hangs from its parent
+    void transplant(T* u, T* v);
+    void rightRotate(T* z);
+    void leftRotate(T* z);
+    // rol is +1 if n's left subtree grew, -1 if its right one did
+    void balanceAfterInsert(T* n, int rol);
+    // rol is -1 if n's left subtree shrank, +1 if its right one did
+    void balanceAfterRemove(T* n, int rol);
+
+    T* root_;
+    size_t size_;
+    KeyOf keyOf_;
+    Compare comp_;
+};
+
+/*
+  ------------------------------------------------------------
+  Begin implementations for the IntrusiveAVLTree::iterator class.
+  ------------------------------------------------------------
+*/
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::iterator() : current_(NULL)
+{
+
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::iterator(T* ptr) : current_(ptr)
+{
+
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+T& IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::operator*() const
+{
+    return *current_;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+T* IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::operator->() const
+{
+    return current_;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+bool IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::operator==(const iterator& rhs) const
+{
+    return current_ == rhs.current_;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+bool IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::operator!=(const iterator& rhs) const
+{
+    return current_ != rhs.current_;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator&
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator::operator++()
+{
+    current_ = successor(current_);
+    return *this;
+}
+
+/*
+  ----------------------------------------------------------
+  End implementations for the IntrusiveAVLTree::iterator class.
+  ----------------------------------------------------------
+*/
+
+/*
+  ---------------------------------------------------
+  Begin implementations for the IntrusiveAVLTree class.
+  ---------------------------------------------------
+*/
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::IntrusiveAVLTree() :
+    root_(NULL), size_(0), keyOf_(), comp_()
+{
+
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::IntrusiveAVLTree(const KeyOf& keyOf, const Compare& comp) :
+    root_(NULL), size_(0), keyOf_(keyOf), comp_(comp)
+{
+
+}
+
+/**
+* Takes over other's objects, leaving other empty.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::IntrusiveAVLTree(IntrusiveAVLTree&& other) noexcept :
+    root_(other.root_), size_(other.size_), keyOf_(other.keyOf_), comp_(other.comp_)
+{
+    other.root_ = NULL;
+    other.size_ = 0;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>&
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::operator=(IntrusiveAVLTree&& other) noexcept
+{
+    if(this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::~IntrusiveAVLTree()
+{
+    clear();
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::swap(IntrusiveAVLTree& other) noexcept
+{
+    std::swap(root_, other.root_);
+    std::swap(size_, other.size_);
+    std::swap(keyOf_, other.keyOf_);
+    std::swap(comp_, other.comp_);
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::hook_type&
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::hook(T* n)
+{
+    return *static_cast<hook_type*>(n);
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+T* IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::successor(T* n)
+{
+    if(hook(n).right_ != NULL) {
+        n = hook(n).right_;
+        while(hook(n).left_ != NULL) {
+            n = hook(n).left_;
+        }
+        return n;
+    }
+    T* parent = hook(n).parent_;
+    while(parent != NULL && n == hook(parent).right_) {
+        n = parent;
+        parent = hook(parent).parent_;
+    }
+    return parent;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+const Key& IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::keyOf(T* n) const
+{
+    return keyOf_(*n);
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+T* IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::findNode(const Key& key) const
+{
+    T* n = root_;
+    while(n != NULL) {
+        if(comp_(key, keyOf(n))) {
+            n = hook(n).left_;
+        }
+        else if(comp_(keyOf(n), key)) {
+            n = hook(n).right_;
+        }
+        else {
+            return n;
+        }
+    }
+    return NULL;
+}
+
+/**
+* Descends to the empty spot for obj's key, links obj there as a leaf
+* and rebalances on the way back up.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+bool IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::insert(T& obj)
+{
+    T* parent = NULL;
+    bool goLeft = false;
+    for(T* n = root_; n != NULL; ) {
+        if(comp_(keyOf(&obj), keyOf(n))) {
+            goLeft = true;
+        }
+        else if(comp_(keyOf(n), keyOf(&obj))) {
+            goLeft = false;
+        }
+        else {
+            return false;
+        }
+        parent = n;
+        n = goLeft ? hook(n).left_ : hook(n).right_;
+    }
+
+    hook_type& h = hook(&obj);
+    h.parent_ = parent;
+    h.left_ = NULL;
+    h.right_ = NULL;
+    h.balance_ = 0;
+    h.linked_ = true;
+    ++size_;
+    if(parent == NULL) {
+        root_ = &obj;
+        return true;
+    }
+    if(goLeft) {
+        hook(parent).left_ = &obj;
+    }
+    else {
+        hook(parent).right_ = &obj;
+    }
+    balanceAfterInsert(parent, goLeft ? 1 : -1);
+    return true;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+T* IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::remove(const Key& key)
+{
+    T* n = findNode(key);
+    if(n != NULL) {
+        unlink(*n);
+    }
+    return n;
+}
+
+/**
+* A node with two children is replaced by its predecessor's object, not
+* by a copy of it, so every other object keeps its place.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::unlink(T& obj)
+{
+    T* z = &obj;
+    hook_type& zh = hook(z);
+    T* start = zh.parent_;      // lowest node whose subtree shrank
+    int rol = (start != NULL && hook(start).left_ == z) ? -1 : 1;
+
+    if(zh.left_ != NULL && zh.right_ != NULL) {
+        T* y = zh.left_;
+        while(hook(y).right_ != NULL) {
+            y = hook(y).right_;
+        }
+        if(y == zh.left_) {
+            start = y;
+            rol = -1;
+        }
+        else {
+            start = hook(y).parent_;
+            rol = 1;
+            transplant(y, hook(y).left_);
+            hook(y).left_ = zh.left_;
+            hook(hook(y).left_).parent_ = y;
+        }
+        transplant(z, y);
+        hook(y).right_ = zh.right_;
+        hook(hook(y).right_).parent_ = y;
+        hook(y).balance_ = zh.balance_;
+    }
+    else {
+        transplant(z, (zh.left_ != NULL) ? zh.left_ : zh.right_);
+    }
+
+    zh.parent_ = NULL;
+    zh.left_ = NULL;
+    zh.right_ = NULL;
+    zh.balance_ = 0;
+    zh.linked_ = false;
+    --size_;
+    balanceAfterRemove(start, rol);
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::erase(iterator pos)
+{
+    iterator next = pos;
+    ++next;
+    unlink(*pos);
+    return next;
+}
+
+/**
+* Resets every hook, leaves first, walking parent links instead of
+* recursing.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::clear()
+{
+    T* n = root_;
+    while(n != NULL) {
+        hook_type& h = hook(n);
+        if(h.left_ != NULL) {
+            n = h.left_;
+        }
+        else if(h.right_ != NULL) {
+            n = h.right_;
+        }
+        else {
+            T* parent = h.parent_;
+            if(parent != NULL) {
+                if(hook(parent).left_ == n) {
+                    hook(parent).left_ = NULL;
+                }
+                else {
+                    hook(parent).right_ = NULL;
+                }
+            }
+            h.parent_ = NULL;
+            h.balance_ = 0;
+            h.linked_ = false;
+            n = parent;
+        }
+    }
+    root_ = NULL;
+    size_ = 0;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+bool IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::empty() const
+{
+    return root_ == NULL;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+size_t IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::size() const
+{
+    return size_;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::begin() const
+{
+    T* n = root_;
+    while(n != NULL && hook(n).left_ != NULL) {
+        n = hook(n).left_;
+    }
+    return iterator(n);
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::end() const
+{
+    return iterator(NULL);
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::find(const Key& key) const
+{
+    return iterator(findNode(key));
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+size_t IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::count(const Key& key) const
+{
+    return (findNode(key) == NULL) ? 0 : 1;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+bool IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::contains(const Key& key) const
+{
+    return findNode(key) != NULL;
+}
+
+/**
+* Returns an iterator to the first object whose key is not less than key.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+typename IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::iterator
+IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::lower_bound(const Key& key) const
+{
+    T* candidate = NULL;
+    T* n = root_;
+    while(n != NULL) {
+        if(comp_(keyOf(n), key)) {
+            n = hook(n).right_;
+        }
+        else {
+            candidate = n;
+            n = hook(n).left_;
+        }
+    }
+    return iterator(candidate);
+}
+
+/**
+ * @precondition The key exists in the tree
+ * Returns the object with the key
+ */
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+T& IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::operator[](const Key& key) const
+{
+    T* n = findNode(key);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    return *n;
+}
+
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::transplant(T* u, T* v)
+{
+    T* parent = hook(u).parent_;
+    if(parent == NULL) {
+        root_ = v;
+    }
+    else if(hook(parent).left_ == u) {
+        hook(parent).left_ = v;
+    }
+    else {
+        hook(parent).right_ = v;
+    }
+    if(v != NULL) {
+        hook(v).parent_ = parent;
+    }
+}
+
+/**
+* z's left child y takes z's place. Balances update the same way as in
+* AVLTree::rightRotate.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::rightRotate(T* z)
+{
+    T* y = hook(z).left_;
+    transplant(z, y);
+    hook(z).left_ = hook(y).right_;
+    if(hook(z).left_ != NULL) {
+        hook(hook(z).left_).parent_ = z;
+    }
+    hook(y).right_ = z;
+    hook(z).parent_ = y;
+
+    int zBalance = hook(z).balance_;
+    int yBalance = hook(y).balance_;
+    zBalance = zBalance - 1 - std::max(yBalance, 0);
+    yBalance = yBalance - 1 + std::min(zBalance, 0);
+    hook(z).balance_ = (int8_t)zBalance;
+    hook(y).balance_ = (int8_t)yBalance;
+}
+
+/**
+* z's right child y takes z's place.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::leftRotate(T* z)
+{
+    T* y = hook(z).right_;
+    transplant(z, y);
+    hook(z).right_ = hook(y).left_;
+    if(hook(z).right_ != NULL) {
+        hook(hook(z).right_).parent_ = z;
+    }
+    hook(y).left_ = z;
+    hook(z).parent_ = y;
+
+    int zBalance = hook(z).balance_;
+    int yBalance = hook(y).balance_;
+    zBalance = zBalance + 1 - std::min(yBalance, 0);
+    yBalance = yBalance + 1 + std::max(zBalance, 0);
+    hook(z).balance_ = (int8_t)zBalance;
+    hook(y).balance_ = (int8_t)yBalance;
+}
+
+/**
+* The insertion retrace from AVLTree::balanceTree: climb while subtrees
+* grow, and stop at a level node or after one single or double rotation.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::balanceAfterInsert(T* n, int rol)
+{
+    while(n != NULL) {
+        hook_type& h = hook(n);
+        h.balance_ = (int8_t)(h.balance_ + rol);
+        if(h.balance_ == 0) {
+            return;
+        }
+        if(h.balance_ > 1) {
+            if(hook(h.left_).balance_ < 0) {
+                leftRotate(h.left_);
+            }
+            rightRotate(n);
+            return;
+        }
+        if(h.balance_ < -1) {
+            if(hook(h.right_).balance_ > 0) {
+                rightRotate(h.right_);
+            }
+            leftRotate(n);
+            return;
+        }
+        T* parent = h.parent_;
+        if(parent != NULL) {
+            rol = (hook(parent).left_ == n) ? 1 : -1;
+        }
+        n = parent;
+    }
+}
+
+/**
+* The removal retrace from AVLTree::balanceTreeForRemove: climb while
+* subtrees shrink, rotating where needed; a rotation around a level
+* child leaves the height unchanged and ends the climb.
+*/
+template<class T, class Key, class KeyOf, class Compare, class Tag>
+void IntrusiveAVLTree<T, Key, KeyOf, Compare, Tag>::balanceAfterRemove(T* n, int rol)
+{
+    while(n != NULL) {
+        hook(n).balance_ = (int8_t)(hook(n).balance_ + rol);
+        int balance = hook(n).balance_;
+        if(balance == 1 || balance == -1) {
+            return;
+        }
+        if(balance > 1) {
+            T* l = hook(n).left_;
+            int childBalance = hook(l).balance_;
+            if(childBalance < 0) {
+                leftRotate(l);
+            }
+            rightRotate(n);
+            n = hook(n).parent_;
+            if(childBalance == 0) {
+                return;
+            }
+        }
+        else if(balance < -1) {
+            T* r = hook(n).right_;
+            int childBalance = hook(r).balance_;
+            if(childBalance > 0) {
+                rightRotate(r);
+            }
+            leftRotate(n);
+            n = hook(n).parent_;
+            if(childBalance == 0) {
+                return;
+            }
+        }
+        T* parent = hook(n).parent_;
+        if(parent != NULL) {
+            rol = (hook(parent).left_ == n) ? -1 : 1;
+        }
+        n = parent;
+    }
+}
+
+/*
+  -------------------------------------------------
+  End implementations for the IntrusiveAVLTree class.
+  -------------------------------------------------
+*/
+
+#endif
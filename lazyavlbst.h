@@ -0,0 +1,677 @@
+#ifndef LAZYAVLBST_H
+#define LAZYAVLBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <vector>
+#include "avlbst.h"
+
+/**
+* An AVL node with a tombstone flag. The flag fits in the tail padding
+* after the balance, so a LazyAVLNode is no larger than an AVLNode.
+*/
+template <typename Key, typename Value>
+class LazyAVLNode : public AVLNode<Key, Value>
+{
+public:
+    LazyAVLNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    LazyAVLNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent);
+    virtual ~LazyAVLNode();
+
+    bool isDead() const;
+    void setDead(bool dead);
+
+    virtual LazyAVLNode<Key, Value>* getParent() const override;
+    virtual LazyAVLNode<Key, Value>* getLeft() const override;
+    virtual LazyAVLNode<Key, Value>* getRight() const override;
+
+    virtual LazyAVLNode<Key, Value>* clone(Node<Key, Value>* parent) const override;
+    virtual LazyAVLNode<Key, Value>* moveInto(void* where, Node<Key, Value>* parent) override;
+    virtual size_t nodeSize() const override;
+
+protected:
+    bool dead_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the LazyAVLNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value>::LazyAVLNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent) :
+    AVLNode<Key, Value>(key, value, parent), dead_(false)
+{
+
+}
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value>::LazyAVLNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent) :
+    AVLNode<Key, Value>(key, std::move(value), parent), dead_(false)
+{
+
+}
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value>::~LazyAVLNode()
+{
+
+}
+
+/**
+* Returns true if the item has been removed but the node not yet purged.
+*/
+template<class Key, class Value>
+bool LazyAVLNode<Key, Value>::isDead() const
+{
+    return dead_;
+}
+
+template<class Key, class Value>
+void LazyAVLNode<Key, Value>::setDead(bool dead)
+{
+    dead_ = dead;
+}
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value> *LazyAVLNode<Key, Value>::getParent() const
+{
+    return static_cast<LazyAVLNode<Key, Value>*>(this->parent_);
+}
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value> *LazyAVLNode<Key, Value>::getLeft() const
+{
+    return static_cast<LazyAVLNode<Key, Value>*>(this->left_);
+}
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value> *LazyAVLNode<Key, Value>::getRight() const
+{
+    return static_cast<LazyAVLNode<Key, Value>*>(this->right_);
+}
+
+/**
+* Copies the item, balance and tombstone flag into a new LazyAVLNode.
+*/
+template<class Key, class Value>
+LazyAVLNode<Key, Value> *LazyAVLNode<Key, Value>::clone(Node<Key, Value>* parent) const
+{
+    LazyAVLNode<Key, Value>* copy = new LazyAVLNode<Key, Value>(this->item_.first, this->item_.second, static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(this->balance_);
+    copy->setDead(dead_);
+    return copy;
+}
+
+template<class Key, class Value>
+LazyAVLNode<Key, Value> *LazyAVLNode<Key, Value>::moveInto(void* where, Node<Key, Value>* parent)
+{
+    LazyAVLNode<Key, Value>* copy = new(where) LazyAVLNode<Key, Value>(this->item_.first, std::move(this->item_.second), static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(this->balance_);
+    copy->setDead(dead_);
+    return copy;
+}
+
+template<class Key, class Value>
+size_t LazyAVLNode<Key, Value>::nodeSize() const
+{
+    return sizeof(LazyAVLNode<Key, Value>);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the LazyAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVL tree with deferred deletion. remove() only marks the node as a
+* tombstone: one descent, no predecessor swap, no retrace. Lookups and
+* iteration skip tombstones, and inserting a tombstoned key revives the
+* node in place.
+*
+* Once tombstones make up more than the purge threshold (default 0.25)
+* of all nodes, purge() runs: one in-order pass frees the dead nodes and
+* relinks the live ones into a perfectly balanced AVL tree. Callers can
+* also run purge() themselves, e.g. between bursts.
+*
+* Lookups made through a BinarySearchTree reference bypass the tombstone
+* checks, so use the tree through its own type.
+*/
+template <class Key, class Value, class Compare = std::less<Key> >
+class LazyAVLTree : public AVLTree<Key, Value, Compare>
+{
+public:
+    /**
+    * Iterator that steps over tombstoned nodes.
+    */
+    class iterator : public BinarySearchTree<Key, Value, Compare>::iterator
+    {
+    public:
+        iterator();
+        iterator& operator++();
+        iterator& operator--();
+
+    protected:
+        friend class LazyAVLTree<Key, Value, Compare>;
+        explicit iterator(const typename BinarySearchTree<Key, Value, Compare>::iterator& it);
+    };
+
+    LazyAVLTree();
+    explicit LazyAVLTree(double purgeThreshold);
+    LazyAVLTree(double purgeThreshold, const Compare& comp);
+    LazyAVLTree(const LazyAVLTree& other);
+    LazyAVLTree(LazyAVLTree&& other) noexcept;
+    LazyAVLTree& operator=(const LazyAVLTree& other);
+    LazyAVLTree& operator=(LazyAVLTree&& other) noexcept;
+    void swap(LazyAVLTree& other) noexcept;
+
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+    virtual void clear();
+    void purge();
+
+    size_t size() const;
+    size_t deadCount() const;
+    bool empty() const;
+    void setPurgeThreshold(double purgeThreshold);
+
+    iterator begin() const;
+    iterator end() const;
+    std::pair<const Key, Value>& back() const;
+    iterator find(const Key& key) const;
+    size_t count(const Key& key) const;
+    bool contains(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+    // Tombstone the items, like remove()
+    iterator erase(iterator pos);
+    iterator erase(iterator first, iterator last);
+
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    size_t count(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    bool contains(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const K& key) const;
+    using BinarySearchTree<Key, Value, Compare>::remove;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    void remove(const K& key);
+
+    // Same as BinarySearchTree's, skipping tombstones
+    template<typename Func>
+    void parallelForEach(Func f, unsigned threads = 0) const;
+    template<typename T, typename Map, typename Combine>
+    T parallelReduce(const T& identity, Map map, Combine combine, unsigned threads = 0) const;
+
+protected:
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    // Marks the node dead instead of unlinking it
+    virtual void removeNode(Node<Key, Value>* n);
+    // Tombstones the live nodes in the range one by one
+    virtual void eraseRange(Node<Key, Value>* first, Node<Key, Value>* last);
+
+    static bool isDead(Node<Key, Value>* n);
+    // Moves a base iterator forward to the first live node
+    static iterator skipDead(const typename BinarySearchTree<Key, Value, Compare>::iterator& it);
+
+    size_t deadCount_;
+    double purgeThreshold_;
+    std::vector<Node<Key, Value>*> purgeBuffer_;   // reused by every purge
+};
+
+/*
+--------------------------------------------------------
+Begin implementations for the LazyAVLTree::iterator class.
+--------------------------------------------------------
+*/
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::iterator::iterator() :
+    BinarySearchTree<Key, Value, Compare>::iterator()
+{
+
+}
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::iterator::iterator(const typename BinarySearchTree<Key, Value, Compare>::iterator& it) :
+    BinarySearchTree<Key, Value, Compare>::iterator(it)
+{
+
+}
+
+/**
+* Advances in order, stepping over tombstones
+*/
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator&
+LazyAVLTree<Key, Value, Compare>::iterator::operator++()
+{
+    do {
+        BinarySearchTree<Key, Value, Compare>::iterator::operator++();
+    } while(this->current_ != NULL && isDead(this->current_));
+    return *this;
+}
+
+/**
+* Steps back in order, stepping over tombstones
+*/
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator&
+LazyAVLTree<Key, Value, Compare>::iterator::operator--()
+{
+    do {
+        BinarySearchTree<Key, Value, Compare>::iterator::operator--();
+    } while(this->current_ != NULL && isDead(this->current_));
+    return *this;
+}
+
+/*
+------------------------------------------------------
+End implementations for the LazyAVLTree::iterator class.
+------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------
+Begin implementations for the LazyAVLTree class.
+-----------------------------------------------
+*/
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::LazyAVLTree() :
+    AVLTree<Key, Value, Compare>(), deadCount_(0), purgeThreshold_(0.25)
+{
+
+}
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::LazyAVLTree(double purgeThreshold) :
+    AVLTree<Key, Value, Compare>(), deadCount_(0), purgeThreshold_(purgeThreshold)
+{
+
+}
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::LazyAVLTree(double purgeThreshold, const Compare& comp) :
+    AVLTree<Key, Value, Compare>(comp), deadCount_(0), purgeThreshold_(purgeThreshold)
+{
+
+}
+
+/**
+* Clones other, tombstones included, without purging.
+*/
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::LazyAVLTree(const LazyAVLTree& other) :
+    AVLTree<Key, Value, Compare>(other), deadCount_(other.deadCount_), purgeThreshold_(other.purgeThreshold_)
+{
+
+}
+
+/**
+* Takes over other's nodes and counters, leaving other empty.
+*/
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>::LazyAVLTree(LazyAVLTree&& other) noexcept :
+    AVLTree<Key, Value, Compare>(std::move(other)), deadCount_(other.deadCount_), purgeThreshold_(other.purgeThreshold_)
+{
+    other.deadCount_ = 0;
+}
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>& LazyAVLTree<Key, Value, Compare>::operator=(const LazyAVLTree& other)
+{
+    if(this != &other) {
+        LazyAVLTree<Key, Value, Compare> copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare>
+LazyAVLTree<Key, Value, Compare>& LazyAVLTree<Key, Value, Compare>::operator=(LazyAVLTree&& other) noexcept
+{
+    if(this != &other) {
+        AVLTree<Key, Value, Compare>::operator=(std::move(other));
+        deadCount_ = other.deadCount_;
+        purgeThreshold_ = other.purgeThreshold_;
+        other.deadCount_ = 0;
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::swap(LazyAVLTree& other) noexcept
+{
+    AVLTree<Key, Value, Compare>::swap(other);
+    std::swap(deadCount_, other.deadCount_);
+    std::swap(purgeThreshold_, other.purgeThreshold_);
+}
+
+template<class Key, class Value, class Compare>
+bool LazyAVLTree<Key, Value, Compare>::isDead(Node<Key, Value>* n)
+{
+    return static_cast<LazyAVLNode<Key, Value>*>(n)->isDead();
+}
+
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::skipDead(const typename BinarySearchTree<Key, Value, Compare>::iterator& it)
+{
+    iterator result(it);
+    if(result.current_ != NULL && isDead(result.current_)) {
+        ++result;
+    }
+    return result;
+}
+
+template<class Key, class Value, class Compare>
+AVLNode<Key, Value>* LazyAVLTree<Key, Value, Compare>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    return new LazyAVLNode<Key, Value>(key, value, parent);
+}
+
+/**
+* Revives a tombstone with the new value, or inserts normally.
+*/
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::insert(const std::pair<const Key, Value>& new_item)
+{
+    Node<Key, Value>* existing = this->internalFind(new_item.first);
+    if(existing != NULL) {
+        existing->setValue(new_item.second);
+        if(isDead(existing)) {
+            static_cast<LazyAVLNode<Key, Value>*>(existing)->setDead(false);
+            --deadCount_;
+        }
+        return;
+    }
+    AVLTree<Key, Value, Compare>::insert(new_item);
+}
+
+/**
+* Tombstones the node and purges once too much of the tree is dead.
+*/
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::removeNode(Node<Key, Value>* n)
+{
+    if(isDead(n)) {
+        return;
+    }
+    static_cast<LazyAVLNode<Key, Value>*>(n)->setDead(true);
+    ++deadCount_;
+    if((double)deadCount_ > purgeThreshold_ * (double)this->count_) {
+        purge();
+    }
+}
+
+/**
+* The next live node is found before pos is tombstoned, and a purge
+* never frees a live node, so it is still valid afterwards.
+*/
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::erase(iterator pos)
+{
+    iterator next = pos;
+    ++next;
+    removeNode(pos.current_);
+    return next;
+}
+
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::erase(iterator first, iterator last)
+{
+    if(first != last) {
+        eraseRange(first.current_, last.current_);
+    }
+    return last;
+}
+
+/**
+* Steps with the tombstone-skipping iterator: a purge partway through
+* frees the dead nodes, so the walk must never stand on one.
+*/
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::eraseRange(Node<Key, Value>* first, Node<Key, Value>* last)
+{
+    iterator it = skipDead(this->iteratorAt(first));
+    while(it.current_ != last) {
+        it = erase(it);
+    }
+}
+
+/**
+* Frees every tombstone and rebuilds the live nodes into a perfectly
+* balanced AVL tree, in one linear pass.
+*/
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::purge()
+{
+    if(deadCount_ == 0) {
+        return;
+    }
+
+    purgeBuffer_.clear();
+    BinarySearchTree<Key, Value, Compare>::flattenSubtree(this->root_, purgeBuffer_);
+
+    // compact the live nodes to the front, freeing the dead ones
+    size_t live = 0;
+    for(size_t i = 0; i < purgeBuffer_.size(); ++i) {
+        if(isDead(purgeBuffer_[i])) {
+            this->destroyNode(purgeBuffer_[i]);
+        }
+        else {
+            purgeBuffer_[live++] = purgeBuffer_[i];
+        }
+    }
+    purgeBuffer_.resize(live);
+
+    int height = 0;
+    this->root_ = AVLTree<Key, Value, Compare>::linkBalancedAVL(purgeBuffer_, 0, live, NULL, height);
+    deadCount_ = 0;
+    this->refreshEnds();
+}
+
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::clear()
+{
+    AVLTree<Key, Value, Compare>::clear();
+    deadCount_ = 0;
+}
+
+/**
+* Returns the number of live items: every node BinarySearchTree counts,
+* less the tombstones.
+*/
+template<class Key, class Value, class Compare>
+size_t LazyAVLTree<Key, Value, Compare>::size() const
+{
+    return this->count_ - deadCount_;
+}
+
+/**
+* Returns the number of tombstones waiting to be purged.
+*/
+template<class Key, class Value, class Compare>
+size_t LazyAVLTree<Key, Value, Compare>::deadCount() const
+{
+    return deadCount_;
+}
+
+template<class Key, class Value, class Compare>
+bool LazyAVLTree<Key, Value, Compare>::empty() const
+{
+    return size() == 0;
+}
+
+/**
+* Sets the dead fraction of all nodes that triggers a purge.
+*/
+template<class Key, class Value, class Compare>
+void LazyAVLTree<Key, Value, Compare>::setPurgeThreshold(double purgeThreshold)
+{
+    purgeThreshold_ = purgeThreshold;
+}
+
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::begin() const
+{
+    return skipDead(BinarySearchTree<Key, Value, Compare>::begin());
+}
+
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::end() const
+{
+    return iterator(BinarySearchTree<Key, Value, Compare>::end());
+}
+
+/**
+* The cached last node may be a tombstone, so step back from end() to
+* the last live item instead.
+*/
+template<class Key, class Value, class Compare>
+std::pair<const Key, Value>& LazyAVLTree<Key, Value, Compare>::back() const
+{
+    if(empty()) {
+        throw std::out_of_range("Empty tree");
+    }
+    return *--end();
+}
+
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::find(const Key& key) const
+{
+    Node<Key, Value>* n = this->internalFind(key);
+    if(n == NULL || isDead(n)) {
+        return end();
+    }
+    return iterator(this->iteratorAt(n));
+}
+
+template<class Key, class Value, class Compare>
+size_t LazyAVLTree<Key, Value, Compare>::count(const Key& key) const
+{
+    return contains(key) ? 1 : 0;
+}
+
+template<class Key, class Value, class Compare>
+bool LazyAVLTree<Key, Value, Compare>::contains(const Key& key) const
+{
+    return find(key) != end();
+}
+
+template<class Key, class Value, class Compare>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::lower_bound(const Key& key) const
+{
+    return skipDead(BinarySearchTree<Key, Value, Compare>::lower_bound(key));
+}
+
+template<class Key, class Value, class Compare>
+Value& LazyAVLTree<Key, Value, Compare>::operator[](const Key& key)
+{
+    iterator it = find(key);
+    if(it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, class Compare>
+Value const & LazyAVLTree<Key, Value, Compare>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if(it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::find(const K& key) const
+{
+    iterator it(BinarySearchTree<Key, Value, Compare>::find(key));
+    if(it.current_ == NULL || isDead(it.current_)) {
+        return end();
+    }
+    return it;
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+size_t LazyAVLTree<Key, Value, Compare>::count(const K& key) const
+{
+    return contains(key) ? 1 : 0;
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+bool LazyAVLTree<Key, Value, Compare>::contains(const K& key) const
+{
+    return find(key) != end();
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+typename LazyAVLTree<Key, Value, Compare>::iterator
+LazyAVLTree<Key, Value, Compare>::lower_bound(const K& key) const
+{
+    return skipDead(BinarySearchTree<Key, Value, Compare>::lower_bound(key));
+}
+
+/**
+* Tombstones the item, like remove(const Key&)
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+void LazyAVLTree<Key, Value, Compare>::remove(const K& key)
+{
+    iterator it(BinarySearchTree<Key, Value, Compare>::find(key));
+    if(it.current_ != NULL) {
+        removeNode(it.current_);
+    }
+}
+
+template<class Key, class Value, class Compare>
+template<typename Func>
+void LazyAVLTree<Key, Value, Compare>::parallelForEach(Func f, unsigned threads) const
+{
+    auto visit = [&f](Node<Key, Value>* n) -> int {
+        if(!isDead(n)) {
+            f(n->getItem());
+        }
+        return 0;
+    };
+    auto ignore = [](int, int) -> int { return 0; };
+    this->parallelReduceNodes(0, visit, ignore, threads);
+}
+
+template<class Key, class Value, class Compare>
+template<typename T, typename Map, typename Combine>
+T LazyAVLTree<Key, Value, Compare>::parallelReduce(const T& identity, Map map, Combine combine, unsigned threads) const
+{
+    // a tombstone contributes identity, which combine ignores
+    auto visit = [&map, &identity](Node<Key, Value>* n) -> T {
+        if(isDead(n)) {
+            return identity;
+        }
+        return map(n->getItem());
+    };
+    return this->parallelReduceNodes(identity, visit, combine, threads);
+}
+
+/*
+---------------------------------------------
+End implementations for the LazyAVLTree class.
+---------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,626 @@
+#ifndef LRUBST_H
+#define LRUBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include "avlbst.h"
+
+/**
+* Weighs an item as nothing beyond its node. A weigher for items that own
+* heap memory (strings, vectors) should return those extra bytes.
+*/
+template <typename Key, typename Value>
+struct NodeOnlyWeigher
+{
+    size_t operator()(const Key&, const Value&) const { return 0; }
+};
+
+/**
+* An AVL node that is also on a doubly linked recency list, and remembers
+* how many bytes it was charged when it was stored.
+*/
+template <typename Key, typename Value>
+class LRUNode : public AVLNode<Key, Value>
+{
+public:
+    LRUNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    LRUNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent);
+    virtual ~LRUNode();
+
+    LRUNode<Key, Value>* getNewer() const;
+    LRUNode<Key, Value>* getOlder() const;
+    void setNewer(LRUNode<Key, Value>* newer);
+    void setOlder(LRUNode<Key, Value>* older);
+    size_t getWeight() const;
+    void setWeight(size_t weight);
+
+    virtual LRUNode<Key, Value>* getParent() const override;
+    virtual LRUNode<Key, Value>* getLeft() const override;
+    virtual LRUNode<Key, Value>* getRight() const override;
+
+    virtual LRUNode<Key, Value>* clone(Node<Key, Value>* parent) const override;
+    virtual LRUNode<Key, Value>* moveInto(void* where, Node<Key, Value>* parent) override;
+    virtual size_t nodeSize() const override;
+
+protected:
+    LRUNode<Key, Value>* newer_;
+    LRUNode<Key, Value>* older_;
+    size_t weight_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the LRUNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+LRUNode<Key, Value>::LRUNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent) :
+    AVLNode<Key, Value>(key, value, parent), newer_(NULL), older_(NULL), weight_(0)
+{
+
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value>::LRUNode(const Key& key, Value&& value, AVLNode<Key, Value>* parent) :
+    AVLNode<Key, Value>(key, std::move(value), parent), newer_(NULL), older_(NULL), weight_(0)
+{
+
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value>::~LRUNode()
+{
+
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value>* LRUNode<Key, Value>::getNewer() const
+{
+    return newer_;
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value>* LRUNode<Key, Value>::getOlder() const
+{
+    return older_;
+}
+
+template<class Key, class Value>
+void LRUNode<Key, Value>::setNewer(LRUNode<Key, Value>* newer)
+{
+    newer_ = newer;
+}
+
+template<class Key, class Value>
+void LRUNode<Key, Value>::setOlder(LRUNode<Key, Value>* older)
+{
+    older_ = older;
+}
+
+template<class Key, class Value>
+size_t LRUNode<Key, Value>::getWeight() const
+{
+    return weight_;
+}
+
+template<class Key, class Value>
+void LRUNode<Key, Value>::setWeight(size_t weight)
+{
+    weight_ = weight;
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value> *LRUNode<Key, Value>::getParent() const
+{
+    return static_cast<LRUNode<Key, Value>*>(this->parent_);
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value> *LRUNode<Key, Value>::getLeft() const
+{
+    return static_cast<LRUNode<Key, Value>*>(this->left_);
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value> *LRUNode<Key, Value>::getRight() const
+{
+    return static_cast<LRUNode<Key, Value>*>(this->right_);
+}
+
+/**
+* Copies the item, balance and weight. The recency links point into the
+* other tree, so the copy starts unlinked and LRUTree relinks it.
+*/
+template<class Key, class Value>
+LRUNode<Key, Value> *LRUNode<Key, Value>::clone(Node<Key, Value>* parent) const
+{
+    LRUNode<Key, Value>* copy = new LRUNode<Key, Value>(
+        this->item_.first, this->item_.second, static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(this->balance_);
+    copy->setWeight(weight_);
+    return copy;
+}
+
+template<class Key, class Value>
+LRUNode<Key, Value> *LRUNode<Key, Value>::moveInto(void* where, Node<Key, Value>* parent)
+{
+    LRUNode<Key, Value>* copy = new(where) LRUNode<Key, Value>(
+        this->item_.first, std::move(this->item_.second), static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(this->balance_);
+    copy->setWeight(weight_);
+    return copy;
+}
+
+template<class Key, class Value>
+size_t LRUNode<Key, Value>::nodeSize() const
+{
+    return sizeof(LRUNode<Key, Value>);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the LRUNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An ordered cache: an AVL tree whose nodes are also threaded on a
+* recency list, so one allocation per entry serves both the ordered
+* index and the eviction order. find() and the non-const operator[]
+* make an entry the most recently used; peek(), contains(), count() and
+* iteration leave the order alone. Iteration is in key order.
+*
+* An entry costs sizeof(LRUNode) plus what the Weigher reports, measured
+* when it is inserted. Once an insert puts the tree over its entry or
+* byte budget, the least recently used entries are removed, each in
+* O(log n), until it fits again. An entry too big for the byte budget on
+* its own is evicted straight away.
+*/
+template <class Key, class Value, class Compare = std::less<Key>, class Weigher = NodeOnlyWeigher<Key, Value> >
+class LRUTree : public AVLTree<Key, Value, Compare>
+{
+public:
+    typedef typename BinarySearchTree<Key, Value, Compare>::iterator iterator;
+
+    explicit LRUTree(size_t maxEntries, size_t maxBytes = std::numeric_limits<size_t>::max());
+    LRUTree(size_t maxEntries, size_t maxBytes, const Weigher& weigher, const Compare& comp = Compare());
+    LRUTree(const LRUTree& other);
+    LRUTree(LRUTree&& other) noexcept;
+    LRUTree& operator=(const LRUTree& other);
+    LRUTree& operator=(LRUTree&& other) noexcept;
+    void swap(LRUTree& other) noexcept;
+
+    // Inserts or overwrites, marks the entry most recent, then evicts
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+    virtual void clear();
+
+    // Lookups that mark the entry most recent
+    iterator find(const Key& key);
+    Value& operator[](const Key& key);
+    // Lookups that don't
+    iterator peek(const Key& key) const;
+    Value const & operator[](const Key& key) const;
+
+    // Heterogeneous versions, as in BinarySearchTree, touching the same way
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key);
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value& operator[](const K& key);
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator peek(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value const & operator[](const K& key) const;
+
+    size_t size() const;
+    size_t bytes() const;
+    size_t maxEntries() const;
+    size_t maxBytes() const;
+    // Changing a budget evicts right away if the tree no longer fits
+    void setMaxEntries(size_t maxEntries);
+    void setMaxBytes(size_t maxBytes);
+
+protected:
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    // Take the node off the recency list and out of the totals first
+    virtual void removeNode(Node<Key, Value>* n);
+    virtual void eraseRange(Node<Key, Value>* first, Node<Key, Value>* last);
+    // compact() moved a node: carry its place on the recency list over
+    virtual void nodeMoved(Node<Key, Value>* from, Node<Key, Value>* to);
+
+    size_t weigh(const Key& key, const Value& value) const;
+    void unlink(LRUNode<Key, Value>* n);
+    void pushNewest(LRUNode<Key, Value>* n);
+    void touch(Node<Key, Value>* n);
+    void evict();
+
+    LRUNode<Key, Value>* newest_;
+    LRUNode<Key, Value>* oldest_;
+    size_t bytes_;
+    size_t maxEntries_;
+    size_t maxBytes_;
+    Weigher weigher_;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the LRUTree class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, class Compare, class Weigher>
+LRUTree<Key, Value, Compare, Weigher>::LRUTree(size_t maxEntries, size_t maxBytes) :
+    AVLTree<Key, Value, Compare>(), newest_(NULL), oldest_(NULL), bytes_(0),
+    maxEntries_(maxEntries), maxBytes_(maxBytes), weigher_()
+{
+
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+LRUTree<Key, Value, Compare, Weigher>::LRUTree(size_t maxEntries, size_t maxBytes, const Weigher& weigher, const Compare& comp) :
+    AVLTree<Key, Value, Compare>(comp), newest_(NULL), oldest_(NULL), bytes_(0),
+    maxEntries_(maxEntries), maxBytes_(maxBytes), weigher_(weigher)
+{
+
+}
+
+/**
+* Clones other's nodes, then threads the copies in other's recency order,
+* finding each copy by key: O(n log n).
+*/
+template<class Key, class Value, class Compare, class Weigher>
+LRUTree<Key, Value, Compare, Weigher>::LRUTree(const LRUTree& other) :
+    AVLTree<Key, Value, Compare>(other), newest_(NULL), oldest_(NULL), bytes_(other.bytes_),
+    maxEntries_(other.maxEntries_), maxBytes_(other.maxBytes_), weigher_(other.weigher_)
+{
+    for(LRUNode<Key, Value>* n = other.oldest_; n != NULL; n = n->getNewer()) {
+        pushNewest(static_cast<LRUNode<Key, Value>*>(this->internalFind(n->getKey())));
+    }
+}
+
+/**
+* Takes over other's nodes and counters, leaving other empty.
+*/
+template<class Key, class Value, class Compare, class Weigher>
+LRUTree<Key, Value, Compare, Weigher>::LRUTree(LRUTree&& other) noexcept :
+    AVLTree<Key, Value, Compare>(std::move(other)), newest_(other.newest_), oldest_(other.oldest_),
+    bytes_(other.bytes_), maxEntries_(other.maxEntries_), maxBytes_(other.maxBytes_),
+    weigher_(other.weigher_)
+{
+    other.newest_ = NULL;
+    other.oldest_ = NULL;
+    other.bytes_ = 0;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+LRUTree<Key, Value, Compare, Weigher>& LRUTree<Key, Value, Compare, Weigher>::operator=(const LRUTree& other)
+{
+    if(this != &other) {
+        LRUTree<Key, Value, Compare, Weigher> copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+LRUTree<Key, Value, Compare, Weigher>& LRUTree<Key, Value, Compare, Weigher>::operator=(LRUTree&& other) noexcept
+{
+    if(this != &other) {
+        BinarySearchTree<Key, Value, Compare>::operator=(std::move(other));
+        newest_ = other.newest_;
+        oldest_ = other.oldest_;
+        bytes_ = other.bytes_;
+        maxEntries_ = other.maxEntries_;
+        maxBytes_ = other.maxBytes_;
+        weigher_ = other.weigher_;
+        other.newest_ = NULL;
+        other.oldest_ = NULL;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::swap(LRUTree& other) noexcept
+{
+    BinarySearchTree<Key, Value, Compare>::swap(other);
+    std::swap(newest_, other.newest_);
+    std::swap(oldest_, other.oldest_);
+    std::swap(bytes_, other.bytes_);
+    std::swap(maxEntries_, other.maxEntries_);
+    std::swap(maxBytes_, other.maxBytes_);
+    std::swap(weigher_, other.weigher_);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+size_t LRUTree<Key, Value, Compare, Weigher>::weigh(const Key& key, const Value& value) const
+{
+    return sizeof(LRUNode<Key, Value>) + weigher_(key, value);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::unlink(LRUNode<Key, Value>* n)
+{
+    if(n->getNewer() != NULL) {
+        n->getNewer()->setOlder(n->getOlder());
+    }
+    else {
+        newest_ = n->getOlder();
+    }
+    if(n->getOlder() != NULL) {
+        n->getOlder()->setNewer(n->getNewer());
+    }
+    else {
+        oldest_ = n->getNewer();
+    }
+    n->setNewer(NULL);
+    n->setOlder(NULL);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::pushNewest(LRUNode<Key, Value>* n)
+{
+    n->setOlder(newest_);
+    n->setNewer(NULL);
+    if(newest_ != NULL) {
+        newest_->setNewer(n);
+    }
+    else {
+        oldest_ = n;
+    }
+    newest_ = n;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::touch(Node<Key, Value>* n)
+{
+    LRUNode<Key, Value>* entry = static_cast<LRUNode<Key, Value>*>(n);
+    if(entry != newest_) {
+        unlink(entry);
+        pushNewest(entry);
+    }
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::evict()
+{
+    while(oldest_ != NULL && (this->count_ > maxEntries_ || bytes_ > maxBytes_)) {
+        removeNode(oldest_);
+    }
+    this->refreshEnds();
+}
+
+/**
+* New nodes start as the most recent entry and are charged to the totals.
+*/
+template<class Key, class Value, class Compare, class Weigher>
+AVLNode<Key, Value>* LRUTree<Key, Value, Compare, Weigher>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    LRUNode<Key, Value>* n = new LRUNode<Key, Value>(key, value, parent);
+    n->setWeight(weigh(key, value));
+    pushNewest(n);
+    bytes_ += n->getWeight();
+    return n;
+}
+
+/**
+* One descent either finds the entry to overwrite or the spot for the
+* new leaf, like AVLTree::insert.
+*/
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::insert(const std::pair<const Key, Value>& new_item)
+{
+    Node<Key, Value>* parent = NULL;
+    bool goLeft = false;
+    Node<Key, Value>* existing = this->descend(new_item.first, parent, goLeft);
+    if(existing != NULL) {
+        LRUNode<Key, Value>* entry = static_cast<LRUNode<Key, Value>*>(existing);
+        entry->setValue(new_item.second);
+        bytes_ -= entry->getWeight();
+        entry->setWeight(weigh(new_item.first, new_item.second));
+        bytes_ += entry->getWeight();
+        touch(entry);
+    }
+    else {
+        AVLNode<Key, Value>* attachTo = static_cast<AVLNode<Key, Value>*>(parent);
+        AVLNode<Key, Value>* n = createNode(new_item.first, new_item.second, attachTo);
+        if(attachTo == NULL) {
+            this->root_ = n;
+            this->nodeLinked(n);
+        }
+        else {
+            this->attachLeaf(attachTo, goLeft, n);
+        }
+    }
+    evict();
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::removeNode(Node<Key, Value>* n)
+{
+    LRUNode<Key, Value>* entry = static_cast<LRUNode<Key, Value>*>(n);
+    unlink(entry);
+    bytes_ -= entry->getWeight();
+    AVLTree<Key, Value, Compare>::removeNode(n);
+}
+
+/**
+* AVLTree frees the range without going through removeNode, so the
+* entries come off the recency list first.
+*/
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::eraseRange(Node<Key, Value>* first, Node<Key, Value>* last)
+{
+    for(Node<Key, Value>* n = first; n != last; n = BinarySearchTree<Key, Value, Compare>::successor(n)) {
+        LRUNode<Key, Value>* entry = static_cast<LRUNode<Key, Value>*>(n);
+        unlink(entry);
+        bytes_ -= entry->getWeight();
+    }
+    AVLTree<Key, Value, Compare>::eraseRange(first, last);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::clear()
+{
+    AVLTree<Key, Value, Compare>::clear();
+    newest_ = NULL;
+    oldest_ = NULL;
+    bytes_ = 0;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::nodeMoved(Node<Key, Value>* from, Node<Key, Value>* to)
+{
+    LRUNode<Key, Value>* old = static_cast<LRUNode<Key, Value>*>(from);
+    LRUNode<Key, Value>* moved = static_cast<LRUNode<Key, Value>*>(to);
+    moved->setNewer(old->getNewer());
+    moved->setOlder(old->getOlder());
+    if(old->getNewer() != NULL) {
+        old->getNewer()->setOlder(moved);
+    }
+    else {
+        newest_ = moved;
+    }
+    if(old->getOlder() != NULL) {
+        old->getOlder()->setNewer(moved);
+    }
+    else {
+        oldest_ = moved;
+    }
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+typename LRUTree<Key, Value, Compare, Weigher>::iterator
+LRUTree<Key, Value, Compare, Weigher>::find(const Key& key)
+{
+    Node<Key, Value>* n = this->internalFind(key);
+    if(n == NULL) {
+        return this->end();
+    }
+    touch(n);
+    return this->iteratorAt(n);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+typename LRUTree<Key, Value, Compare, Weigher>::iterator
+LRUTree<Key, Value, Compare, Weigher>::peek(const Key& key) const
+{
+    return BinarySearchTree<Key, Value, Compare>::find(key);
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key and marks it most recent.
+ * Changing the value through the reference doesn't reweigh the entry.
+ */
+template<class Key, class Value, class Compare, class Weigher>
+Value& LRUTree<Key, Value, Compare, Weigher>::operator[](const Key& key)
+{
+    Node<Key, Value>* n = this->internalFind(key);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    touch(n);
+    return n->getValue();
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+Value const & LRUTree<Key, Value, Compare, Weigher>::operator[](const Key& key) const
+{
+    return BinarySearchTree<Key, Value, Compare>::operator[](key);
+}
+
+/**
+* Heterogeneous find(), marking the entry most recent
+*/
+template<class Key, class Value, class Compare, class Weigher>
+template<typename K, typename C, typename>
+typename LRUTree<Key, Value, Compare, Weigher>::iterator
+LRUTree<Key, Value, Compare, Weigher>::find(const K& key)
+{
+    Node<Key, Value>* parent = NULL;
+    bool isLeft = false;
+    Node<Key, Value>* n = this->descend(key, parent, isLeft);
+    if(n == NULL) {
+        return this->end();
+    }
+    touch(n);
+    return this->iteratorAt(n);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+template<typename K, typename C, typename>
+Value& LRUTree<Key, Value, Compare, Weigher>::operator[](const K& key)
+{
+    Node<Key, Value>* parent = NULL;
+    bool isLeft = false;
+    Node<Key, Value>* n = this->descend(key, parent, isLeft);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    touch(n);
+    return n->getValue();
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+template<typename K, typename C, typename>
+typename LRUTree<Key, Value, Compare, Weigher>::iterator
+LRUTree<Key, Value, Compare, Weigher>::peek(const K& key) const
+{
+    return BinarySearchTree<Key, Value, Compare>::find(key);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+template<typename K, typename C, typename>
+Value const & LRUTree<Key, Value, Compare, Weigher>::operator[](const K& key) const
+{
+    return BinarySearchTree<Key, Value, Compare>::operator[](key);
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+size_t LRUTree<Key, Value, Compare, Weigher>::size() const
+{
+    return this->count_;
+}
+
+/**
+* Returns the bytes charged to the entries currently stored.
+*/
+template<class Key, class Value, class Compare, class Weigher>
+size_t LRUTree<Key, Value, Compare, Weigher>::bytes() const
+{
+    return bytes_;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+size_t LRUTree<Key, Value, Compare, Weigher>::maxEntries() const
+{
+    return maxEntries_;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+size_t LRUTree<Key, Value, Compare, Weigher>::maxBytes() const
+{
+    return maxBytes_;
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::setMaxEntries(size_t maxEntries)
+{
+    maxEntries_ = maxEntries;
+    evict();
+}
+
+template<class Key, class Value, class Compare, class Weigher>
+void LRUTree<Key, Value, Compare, Weigher>::setMaxBytes(size_t maxBytes)
+{
+    maxBytes_ = maxBytes;
+    evict();
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the LRUTree class.
+  ---------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MEMUSAGE_H
+#define MEMUSAGE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+* What the allocator really hands out for a request of size bytes: the
+* request plus glibc malloc's size header, rounded up to its 16-byte
+* alignment, and never less than its 32-byte minimum chunk. Other
+* mallocs round differently but land close to this.
+*/
+inline size_t allocatedBytes(size_t size)
+{
+    const size_t header = sizeof(size_t);
+    const size_t align = 2 * sizeof(size_t);
+    size_t chunk = (size + header + align - 1) & ~(align - 1);
+    return (chunk < 4 * sizeof(size_t)) ? 4 * sizeof(size_t) : chunk;
+}
+
+/**
+* The heap memory a key or value owns outside its node, which is where
+* memoryUsage() gets its heapBytes. Plain types own none. Specialize
+* this for your own types that allocate, the way std::string, vector
+* and pair are below.
+*/
+template<typename T>
+struct HeapBytes
+{
+    static size_t of(const T&) { return 0; }
+};
+
+template<typename Char, typename Traits, typename Alloc>
+struct HeapBytes<std::basic_string<Char, Traits, Alloc> >
+{
+    static size_t of(const std::basic_string<Char, Traits, Alloc>& s)
+    {
+        // short strings live inside the string object itself
+        const char* data = (const char*)s.data();
+        const char* self = (const char*)&s;
+        if(data >= self && data < self + sizeof(s)) {
+            return 0;
+        }
+        return allocatedBytes((s.capacity() + 1) * sizeof(Char));
+    }
+};
+
+template<typename T, typename Alloc>
+struct HeapBytes<std::vector<T, Alloc> >
+{
+    static size_t of(const std::vector<T, Alloc>& v)
+    {
+        size_t bytes = v.capacity() ? allocatedBytes(v.capacity() * sizeof(T)) : 0;
+        for(size_t i = 0; i < v.size(); ++i) {
+            bytes += HeapBytes<T>::of(v[i]);
+        }
+        return bytes;
+    }
+};
+
+template<typename A, typename B>
+struct HeapBytes<std::pair<A, B> >
+{
+    static size_t of(const std::pair<A, B>& p)
+    {
+        return HeapBytes<A>::of(p.first) + HeapBytes<B>::of(p.second);
+    }
+};
+
+/**
+* Where a tree's memory goes, from BinarySearchTree::memoryUsage().
+* The tree object itself is not counted; it lives wherever its owner
+* put it.
+*/
+struct TreeMemoryUsage
+{
+    TreeMemoryUsage() : nodes(0), nodeSize(0), nodeAllocated(0), heapBytes(0), compactedNodes(0), arenaBytes(0) {}
+
+    size_t nodes;
+    size_t nodeSize;        // sizeof the node type, padding included
+    size_t nodeAllocated;   // one node as the allocator hands it out
+    size_t heapBytes;       // owned by keys and values outside the nodes
+    size_t compactedNodes;  // nodes that compact() moved into blocks
+    size_t arenaBytes;      // those blocks, holes and spare room included
+
+    size_t total() const { return (nodes - compactedNodes) * nodeAllocated + arenaBytes + heapBytes; }
+};
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef MULTIAVLBST_H
+#define MULTIAVLBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <utility>
+#include "avlbst.h"
+
+/**
+* An AVL tree that keeps every inserted item, so one key can map to many
+* values (a multimap). A new item goes after every item with an equal
+* key, and rotations and removals keep the in-order sequence, so items
+* with equal keys iterate in insertion order. Heights stay within the
+* usual AVL bound.
+*
+* find() and operator[] use the oldest item with the key; equal_range()
+* gives all of them.
+*/
+template <class Key, class Value, class Compare = std::less<Key> >
+class MultiAVLTree : public AVLTree<Key, Value, Compare>
+{
+public:
+    typedef typename BinarySearchTree<Key, Value, Compare>::iterator iterator;
+
+    MultiAVLTree();
+    explicit MultiAVLTree(const Compare& comp);
+
+    // Adds the item even if the key is already present
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+    // Removes every item with the key
+    virtual void remove(const Key& key);
+    // Removes the oldest item with the key; returns false if there is none
+    bool removeOne(const Key& key);
+
+    iterator find(const Key& key) const;
+    size_t count(const Key& key) const;
+    iterator upper_bound(const Key& key) const;
+    std::pair<iterator, iterator> equal_range(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+    // Heterogeneous versions, as in BinarySearchTree
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    void remove(const K& key);
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    bool removeOne(const K& key);
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    size_t count(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<iterator, iterator> equal_range(const K& key) const;
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value& operator[](const K& key);
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    Value const & operator[](const K& key) const;
+
+protected:
+    // Returns the first node whose key is greater than key, or NULL.
+    template<typename K>
+    Node<Key, Value>* upperBoundNode(const K& key) const;
+    // Returns the oldest node holding key, or NULL.
+    template<typename K>
+    Node<Key, Value>* firstEqualNode(const K& key) const;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the MultiAVLTree class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, class Compare>
+MultiAVLTree<Key, Value, Compare>::MultiAVLTree() : AVLTree<Key, Value, Compare>()
+{
+
+}
+
+template<class Key, class Value, class Compare>
+MultiAVLTree<Key, Value, Compare>::MultiAVLTree(const Compare& comp) : AVLTree<Key, Value, Compare>(comp)
+{
+
+}
+
+/**
+* Descends as if searching for the upper bound of the key, one
+* comparison per level, and attaches the new leaf where that search
+* ends: after every item with an equal key.
+*/
+template<class Key, class Value, class Compare>
+void MultiAVLTree<Key, Value, Compare>::insert(const std::pair<const Key, Value>& new_item)
+{
+    AVLNode<Key, Value>* parent = NULL;
+    bool goLeft = false;
+    for(Node<Key, Value>* temp = this->root_; temp != NULL; ) {
+        parent = static_cast<AVLNode<Key, Value>*>(temp);
+        goLeft = this->comp_(new_item.first, temp->getKey());
+        temp = goLeft ? temp->getLeft() : temp->getRight();
+    }
+
+    AVLNode<Key, Value>* n = this->createNode(new_item.first, new_item.second, parent);
+    if(parent == NULL) {
+        this->root_ = n;
+        this->nodeLinked(n);
+        return;
+    }
+    this->attachLeaf(parent, goLeft, n);
+}
+
+template<class Key, class Value, class Compare>
+template<typename K>
+Node<Key, Value>* MultiAVLTree<Key, Value, Compare>::upperBoundNode(const K& key) const
+{
+    Node<Key, Value>* candidate = NULL;
+    Node<Key, Value>* temp = this->root_;
+    while(temp != NULL) {
+        if(this->comp_(key, temp->getKey())) {
+            candidate = temp;
+            temp = temp->getLeft();
+        }
+        else {
+            temp = temp->getRight();
+        }
+    }
+    return candidate;
+}
+
+template<class Key, class Value, class Compare>
+template<typename K>
+Node<Key, Value>* MultiAVLTree<Key, Value, Compare>::firstEqualNode(const K& key) const
+{
+    Node<Key, Value>* n = this->lowerBoundNode(key);
+    if(n == NULL || this->comp_(key, n->getKey())) {
+        return NULL;
+    }
+    return n;
+}
+
+/**
+* Removes every item with the key by cutting equal_range() out in one
+* go through AVLTree's split and join, so this takes O(log n + k) for k
+* items rather than a rebalancing removal per item.
+*/
+template<class Key, class Value, class Compare>
+void MultiAVLTree<Key, Value, Compare>::remove(const Key& key)
+{
+    std::pair<iterator, iterator> range = equal_range(key);
+    this->erase(range.first, range.second);
+}
+
+template<class Key, class Value, class Compare>
+bool MultiAVLTree<Key, Value, Compare>::removeOne(const Key& key)
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    if(n == NULL) {
+        return false;
+    }
+    this->removeNode(n);
+    this->refreshEnds();
+    return true;
+}
+
+/**
+* Returns an iterator to the oldest item with the key, or end().
+*/
+template<class Key, class Value, class Compare>
+typename MultiAVLTree<Key, Value, Compare>::iterator
+MultiAVLTree<Key, Value, Compare>::find(const Key& key) const
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    return (n == NULL) ? this->end() : this->iteratorAt(n);
+}
+
+/**
+* Counts the items with the key by walking equal_range, O(log n + k).
+*/
+template<class Key, class Value, class Compare>
+size_t MultiAVLTree<Key, Value, Compare>::count(const Key& key) const
+{
+    std::pair<iterator, iterator> range = equal_range(key);
+    size_t result = 0;
+    for(iterator it = range.first; it != range.second; ++it) {
+        ++result;
+    }
+    return result;
+}
+
+template<class Key, class Value, class Compare>
+typename MultiAVLTree<Key, Value, Compare>::iterator
+MultiAVLTree<Key, Value, Compare>::upper_bound(const Key& key) const
+{
+    return this->iteratorAt(upperBoundNode(key));
+}
+
+/**
+* Returns the items with the key as [first, second), oldest first.
+*/
+template<class Key, class Value, class Compare>
+std::pair<typename MultiAVLTree<Key, Value, Compare>::iterator, typename MultiAVLTree<Key, Value, Compare>::iterator>
+MultiAVLTree<Key, Value, Compare>::equal_range(const Key& key) const
+{
+    return std::make_pair(this->iteratorAt(this->lowerBoundNode(key)), this->iteratorAt(upperBoundNode(key)));
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value of the oldest item with the key
+ */
+template<class Key, class Value, class Compare>
+Value& MultiAVLTree<Key, Value, Compare>::operator[](const Key& key)
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    return n->getValue();
+}
+
+template<class Key, class Value, class Compare>
+Value const & MultiAVLTree<Key, Value, Compare>::operator[](const Key& key) const
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    return n->getValue();
+}
+
+/**
+* Heterogeneous versions of the above: the same bodies, searching with a
+* key the comparator orders against Key, so no temporary Key is built.
+*/
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+void MultiAVLTree<Key, Value, Compare>::remove(const K& key)
+{
+    std::pair<iterator, iterator> range = equal_range(key);
+    this->erase(range.first, range.second);
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+bool MultiAVLTree<Key, Value, Compare>::removeOne(const K& key)
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    if(n == NULL) {
+        return false;
+    }
+    this->removeNode(n);
+    this->refreshEnds();
+    return true;
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+typename MultiAVLTree<Key, Value, Compare>::iterator
+MultiAVLTree<Key, Value, Compare>::find(const K& key) const
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    return (n == NULL) ? this->end() : this->iteratorAt(n);
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+size_t MultiAVLTree<Key, Value, Compare>::count(const K& key) const
+{
+    std::pair<iterator, iterator> range = equal_range(key);
+    size_t result = 0;
+    for(iterator it = range.first; it != range.second; ++it) {
+        ++result;
+    }
+    return result;
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+typename MultiAVLTree<Key, Value, Compare>::iterator
+MultiAVLTree<Key, Value, Compare>::upper_bound(const K& key) const
+{
+    return this->iteratorAt(upperBoundNode(key));
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+std::pair<typename MultiAVLTree<Key, Value, Compare>::iterator, typename MultiAVLTree<Key, Value, Compare>::iterator>
+MultiAVLTree<Key, Value, Compare>::equal_range(const K& key) const
+{
+    return std::make_pair(this->iteratorAt(this->lowerBoundNode(key)), this->iteratorAt(upperBoundNode(key)));
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+Value& MultiAVLTree<Key, Value, Compare>::operator[](const K& key)
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    return n->getValue();
+}
+
+template<class Key, class Value, class Compare>
+template<typename K, typename C, typename>
+Value const & MultiAVLTree<Key, Value, Compare>::operator[](const K& key) const
+{
+    Node<Key, Value>* n = firstEqualNode(key);
+    if(n == NULL) throw std::out_of_range("Invalid key");
+    return n->getValue();
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the MultiAVLTree class.
+  ---------------------------------------------
+*/
+
+#endif
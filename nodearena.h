@@ -0,0 +1,191 @@
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include "memusage.h"
+
+/**
+* The blocks a compacted tree keeps its nodes in. Nodes are placed one
+* after another in a block, in the order the tree asks for them, so a
+* layout chosen by the tree ends up contiguous in memory.
+*
+* Slots are never reused: a node freed from a block just leaves a hole,
+* and the block goes back to the heap once its last node is freed. A
+* later compaction moves the survivors out of old blocks, which frees
+* them. Blocks are kept sorted by address so owns() is a binary search,
+* and an arena that holds nothing answers without looking at all.
+*/
+class NodeArena
+{
+public:
+    NodeArena();
+    ~NodeArena();
+    void swap(NodeArena& other) noexcept;
+
+    // Starts a new layout: later nodes go in fresh blocks rather than
+    // after whatever the current block already holds.
+    void newRun();
+    // Makes sure the next count slots of slotSize bytes come from one
+    // block, starting a new block if the current one is too small.
+    void reserve(size_t slotSize, size_t count);
+    // The next slot; reserve() must have made room for it.
+    void* allocate();
+
+    bool empty() const;
+    bool owns(const void* p) const;
+    // Gives back a slot whose node has been destroyed; the block is freed
+    // when it was the last one in it.
+    void release(const void* p);
+
+    // Slots holding nodes, and bytes of blocks held, as the allocator
+    // hands them out
+    size_t liveSlots() const;
+    size_t bytes() const;
+
+private:
+    NodeArena(const NodeArena&);
+    NodeArena& operator=(const NodeArena&);
+
+    struct Block
+    {
+        char* base;
+        size_t slotSize;
+        size_t capacity;
+        size_t used;
+        size_t live;
+    };
+
+    // Index of the block holding p, or blocks_.size()
+    size_t find(const void* p) const;
+
+    std::vector<Block> blocks_;
+    // Base of the block new slots come from, or NULL between runs
+    char* current_;
+};
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the NodeArena class.
+  ----------------------------------------------------
+*/
+
+inline NodeArena::NodeArena() : current_(NULL)
+{
+}
+
+inline NodeArena::~NodeArena()
+{
+    for(size_t i = 0; i < blocks_.size(); ++i) {
+        ::operator delete(blocks_[i].base);
+    }
+}
+
+inline void NodeArena::swap(NodeArena& other) noexcept
+{
+    blocks_.swap(other.blocks_);
+    std::swap(current_, other.current_);
+}
+
+inline void NodeArena::newRun()
+{
+    current_ = NULL;
+}
+
+/**
+* A run that outgrows its block carries on in one twice the size, so a
+* layout built in many small slices still lands in a few large blocks.
+*/
+inline void NodeArena::reserve(size_t slotSize, size_t count)
+{
+    size_t previous = 0;
+    if(current_ != NULL) {
+        Block& block = blocks_[find(current_)];
+        if(block.slotSize == slotSize && block.capacity - block.used >= count) {
+            return;
+        }
+        previous = block.capacity;
+    }
+
+    Block block;
+    block.slotSize = slotSize;
+    block.capacity = std::max(count, 2 * previous);
+    block.used = 0;
+    block.live = 0;
+    blocks_.reserve(blocks_.size() + 1);
+    block.base = static_cast<char*>(::operator new(block.capacity * slotSize));
+    blocks_.insert(std::upper_bound(blocks_.begin(), blocks_.end(), block,
+                                    [](const Block& a, const Block& b) { return a.base < b.base; }), block);
+    current_ = block.base;
+}
+
+inline void* NodeArena::allocate()
+{
+    Block& block = blocks_[find(current_)];
+    ++block.live;
+    return block.base + block.slotSize * block.used++;
+}
+
+inline bool NodeArena::empty() const
+{
+    return blocks_.empty();
+}
+
+inline bool NodeArena::owns(const void* p) const
+{
+    return !blocks_.empty() && find(p) < blocks_.size();
+}
+
+inline void NodeArena::release(const void* p)
+{
+    size_t i = find(p);
+    if(i == blocks_.size() || --blocks_[i].live > 0) {
+        return;
+    }
+    std::vector<Block>::iterator block = blocks_.begin() + i;
+    if(block->base == current_) {
+        current_ = NULL;
+    }
+    ::operator delete(block->base);
+    blocks_.erase(block);
+}
+
+inline size_t NodeArena::liveSlots() const
+{
+    size_t live = 0;
+    for(size_t i = 0; i < blocks_.size(); ++i) {
+        live += blocks_[i].live;
+    }
+    return live;
+}
+
+inline size_t NodeArena::bytes() const
+{
+    size_t total = 0;
+    for(size_t i = 0; i < blocks_.size(); ++i) {
+        total += allocatedBytes(blocks_[i].capacity * blocks_[i].slotSize);
+    }
+    return total;
+}
+
+inline size_t NodeArena::find(const void* p) const
+{
+    const char* c = static_cast<const char*>(p);
+    // the last block starting at or before p
+    size_t i = std::upper_bound(blocks_.begin(), blocks_.end(), c,
+        [](const char* addr, const Block& b) { return addr < b.base; }) - blocks_.begin();
+    if(i == 0 || c >= blocks_[i - 1].base + blocks_[i - 1].slotSize * blocks_[i - 1].capacity) {
+        return blocks_.size();
+    }
+    return i - 1;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the NodeArena class.
+  ----------------------------------------------------
+*/
+
+#endif
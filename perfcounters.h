@@ -0,0 +1,168 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/**
+* Hardware event counters for the benchmarks, read through Linux
+* perf_event_open. The counters are opened once and left running for
+* this thread and any threads it starts afterwards; a measurement takes
+* a snapshot before and after and reports the difference.
+*
+* Any event the kernel or hardware won't give us (no PMU in a VM,
+* perf_event_paranoid too high, not Linux at all) just reads as
+* unavailable, and the rest carry on. available() is false when none
+* opened, and why() says what went wrong with the first that failed.
+*/
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        DTLB_MISSES,
+        EVENT_COUNT
+    };
+
+    struct Snapshot
+    {
+        uint64_t values[EVENT_COUNT];
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    bool available() const;
+    bool available(Event e) const;
+    const std::string& why() const;
+    static const char* name(Event e);
+
+    // Current counts, scaled up when the kernel had to multiplex
+    // counters; unavailable events read as 0.
+    Snapshot read() const;
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    int fds_[EVENT_COUNT];
+    std::string why_;
+};
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the PerfCounters class.
+  ----------------------------------------------------
+*/
+
+inline PerfCounters::PerfCounters()
+{
+    for(int e = 0; e < EVENT_COUNT; ++e) {
+        fds_[e] = -1;
+    }
+#ifdef __linux__
+    const uint32_t types[EVENT_COUNT] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+    };
+    const uint64_t readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const uint64_t configs[EVENT_COUNT] = {
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | readMiss,
+        PERF_COUNT_HW_CACHE_LL | readMiss,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_DTLB | readMiss
+    };
+    for(int e = 0; e < EVENT_COUNT; ++e) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[e];
+        attr.config = configs[e];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds_[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if(fds_[e] < 0 && why_.empty()) {
+            why_ = std::string(name((Event)e)) + ": " + std::strerror(errno);
+        }
+    }
+#else
+    why_ = "perf_event_open needs Linux";
+#endif
+}
+
+inline PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for(int e = 0; e < EVENT_COUNT; ++e) {
+        if(fds_[e] >= 0) {
+            close(fds_[e]);
+        }
+    }
+#endif
+}
+
+inline bool PerfCounters::available() const
+{
+    for(int e = 0; e < EVENT_COUNT; ++e) {
+        if(fds_[e] >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool PerfCounters::available(Event e) const
+{
+    return fds_[e] >= 0;
+}
+
+inline const std::string& PerfCounters::why() const
+{
+    return why_;
+}
+
+inline const char* PerfCounters::name(Event e)
+{
+    static const char* names[EVENT_COUNT] = { "instructions", "L1d misses", "LLC misses", "branch misses", "dTLB misses" };
+    return names[e];
+}
+
+inline PerfCounters::Snapshot PerfCounters::read() const
+{
+    Snapshot snap;
+    for(int e = 0; e < EVENT_COUNT; ++e) {
+        snap.values[e] = 0;
+#ifdef __linux__
+        // value, time enabled, time running
+        uint64_t data[3];
+        if(fds_[e] >= 0 && ::read(fds_[e], data, sizeof(data)) == (ssize_t)sizeof(data)) {
+            snap.values[e] = (data[2] > 0 && data[2] < data[1])
+                ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+        }
+#endif
+    }
+    return snap;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the PerfCounters class.
+  ----------------------------------------------------
+*/
+
+#endif
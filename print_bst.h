@@ -13,12 +13,37 @@
 // maximum depth of tree to actually print.
 #define PPBST_MAX_HEIGHT 6
 
+// Prints v if it has an operator<<, otherwise a placeholder, so trees
+// whose keys or values can't be printed (pairs, for instance) still
+// compile. Pairs print as (first, second).
+template<typename T>
+auto ppbstPrint(std::ostream& out, const T& v, int) -> decltype(out << v, void())
+{
+    out << v;
+}
+
+template<typename T>
+void ppbstPrint(std::ostream& out, const T&, long)
+{
+    out << "<?>";
+}
+
+template<typename A, typename B>
+void ppbstPrint(std::ostream& out, const std::pair<A, B>& v, int)
+{
+    out << '(';
+    ppbstPrint(out, v.first, 0);
+    out << ", ";
+    ppbstPrint(out, v.second, 0);
+    out << ')';
+}
+
 // Returns the node's distance from the given root.
 // 1 means that it is the root.
 // Returns -1 (not found) if the distance is more than PPBST_MAX_HEIGHT,
 // or -2 if the tree is inconsistent.
-template<typename Key, typename Value>
-int getNodeDepth(BinarySearchTree<Key, Value> const & tree, Node<Key, Value> * root, Node<Key, Value> * node)
+template<typename Key, typename Value, typename Compare>
+int getNodeDepth(BinarySearchTree<Key, Value, Compare> const & tree, Node<Key, Value> * root, Node<Key, Value> * node)
 {
     int dist = 1;
 
@@ -92,8 +117,8 @@ int getSubtreeHeight(Node<Key, Value> * root, int recursionDepth = 1)
 
     */
 
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
+template<typename Key, typename Value, typename Compare>
+void BinarySearchTree<Key, Value, Compare>::printRoot (Node<Key, Value>* root) const
 {
     // special case for empty trees:
     if(root == nullptr)
@@ -127,10 +152,10 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
 
     // get placeholders
     // ----------------------------------------------------------------------
-    std::map<Key, uint8_t> valuePlaceholders;
+    std::map<Key, uint8_t, Compare> valuePlaceholders(comp_);
 
     uint8_t nextPlaceHolderVal = 1;
-    for(typename BinarySearchTree<Key, Value>::iterator treeIter = this->begin(); treeIter != this->end(); ++treeIter)
+    for(typename BinarySearchTree<Key, Value, Compare>::iterator treeIter = this->begin(); treeIter != this->end(); ++treeIter)
     {
 
         if(getNodeDepth(*this, root, treeIter.current_) != -1)
@@ -258,29 +283,31 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
     std::cout << std::endl;
     if(clippedFinalElements)
     {
-        std::cout << "(deeper levels omitted due to space limitations)" << std::endl;
+        std::cout << "(deeper levels omitted due to space limitations; exportTree() writes them all)" << std::endl;
     }
 
 
     if(!std::is_same<Key, uint8_t>::value) // print placeholder explanations if needed:
     {
         std::cout << "Tree Placeholders:------------------" << std::endl;
-        for(typename std::map<Key, uint8_t>::iterator placeholdersIter = valuePlaceholders.begin(); placeholdersIter != valuePlaceholders.end(); ++placeholdersIter)
+        for(typename std::map<Key, uint8_t, Compare>::iterator placeholdersIter = valuePlaceholders.begin(); placeholdersIter != valuePlaceholders.end(); ++placeholdersIter)
         {
             std::cout << '[' << std::setfill('0') << std::setw(2) << ((uint16_t)placeholdersIter->second) << "] -> ";
 
             // print element with original cout flags
             std::cout.flags(origCoutState);
-            std::cout << '(' << placeholdersIter->first << ", ";
+            std::cout << '(';
+            ppbstPrint(std::cout, placeholdersIter->first, 0);
+            std::cout << ", ";
 
-            typename BinarySearchTree<Key, Value>::iterator elementIter = this->find(placeholdersIter->first);
+            typename BinarySearchTree<Key, Value, Compare>::iterator elementIter = this->find(placeholdersIter->first);
             if(elementIter == this->end())
             {
                 std::cout << "<error: lookup failed>";
             }
             else
             {
-                std::cout << elementIter->second;
+                ppbstPrint(std::cout, elementIter->second, 0);
             }
 
             std::cout << ')' << std::endl;
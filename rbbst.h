@@ -0,0 +1,467 @@
+#ifndef RBBST_H
+#define RBBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include "bst.h"
+
+/**
+* A node for a red-black tree, which adds the color as a data member.
+* The flag is a single byte that lands in the node's tail padding, the
+* same way the AVL balance does, so an RBNode is no larger than an AVLNode.
+*/
+template <typename Key, typename Value>
+class RBNode : public Node<Key, Value>
+{
+public:
+    // Constructor/destructor. New nodes start out red.
+    RBNode(const Key& key, const Value& value, RBNode<Key, Value>* parent);
+    RBNode(const Key& key, Value&& value, RBNode<Key, Value>* parent);
+    virtual ~RBNode();
+
+    // Getter/setter for the node's color.
+    bool isRed() const;
+    void setRed(bool red);
+
+    // Getters for parent, left, and right. These need to be redefined since they
+    // return pointers to RBNodes - not plain Nodes.
+    virtual RBNode<Key, Value>* getParent() const override;
+    virtual RBNode<Key, Value>* getLeft() const override;
+    virtual RBNode<Key, Value>* getRight() const override;
+
+    virtual RBNode<Key, Value>* clone(Node<Key, Value>* parent) const override;
+    virtual RBNode<Key, Value>* moveInto(void* where, Node<Key, Value>* parent) override;
+    virtual size_t nodeSize() const override;
+
+protected:
+    bool red_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the RBNode class.
+  -------------------------------------------------
+*/
+
+/**
+* An explicit constructor to initialize the elements by calling the base class constructor
+*/
+template<class Key, class Value>
+RBNode<Key, Value>::RBNode(const Key& key, const Value& value, RBNode<Key, Value> *parent) :
+    Node<Key, Value>(key, value, parent), red_(true)
+{
+
+}
+
+template<class Key, class Value>
+RBNode<Key, Value>::RBNode(const Key& key, Value&& value, RBNode<Key, Value> *parent) :
+    Node<Key, Value>(key, std::move(value), parent), red_(true)
+{
+
+}
+
+/**
+* A destructor which does nothing.
+*/
+template<class Key, class Value>
+RBNode<Key, Value>::~RBNode()
+{
+
+}
+
+/**
+* Returns true if the node is red, false if it is black.
+*/
+template<class Key, class Value>
+bool RBNode<Key, Value>::isRed() const
+{
+    return red_;
+}
+
+/**
+* Colors the node red (true) or black (false).
+*/
+template<class Key, class Value>
+void RBNode<Key, Value>::setRed(bool red)
+{
+    red_ = red;
+}
+
+/**
+* An overridden function for getting the parent since a static_cast is necessary to make sure
+* that our node is a RBNode.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::getParent() const
+{
+    return static_cast<RBNode<Key, Value>*>(this->parent_);
+}
+
+/**
+* Overridden for the same reasons as above.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::getLeft() const
+{
+    return static_cast<RBNode<Key, Value>*>(this->left_);
+}
+
+/**
+* Overridden for the same reasons as above.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::getRight() const
+{
+    return static_cast<RBNode<Key, Value>*>(this->right_);
+}
+
+/**
+* Copies the item and the color into a new RBNode.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::clone(Node<Key, Value>* parent) const
+{
+    RBNode<Key, Value>* copy = new RBNode<Key, Value>(this->item_.first, this->item_.second, static_cast<RBNode<Key, Value>*>(parent));
+    copy->setRed(red_);
+    return copy;
+}
+
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::moveInto(void* where, Node<Key, Value>* parent)
+{
+    RBNode<Key, Value>* copy = new(where) RBNode<Key, Value>(this->item_.first, std::move(this->item_.second), static_cast<RBNode<Key, Value>*>(parent));
+    copy->setRed(red_);
+    return copy;
+}
+
+template<class Key, class Value>
+size_t RBNode<Key, Value>::nodeSize() const
+{
+    return sizeof(RBNode<Key, Value>);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the RBNode class.
+  -----------------------------------------------
+*/
+
+/**
+* A red-black tree. Insertion does at most two rotations and removal at
+* most three; everything else is recoloring, so delete-heavy workloads
+* restructure far less than an AVL tree, at the price of a looser
+* height bound (2 log n instead of about 1.44 log n).
+*/
+template <class Key, class Value, class Compare = std::less<Key> >
+class RedBlackTree : public BinarySearchTree<Key, Value, Compare>
+{
+public:
+    RedBlackTree();
+    explicit RedBlackTree(const Compare& comp);
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+protected:
+    virtual void removeNode(Node<Key, Value>* temp);
+    virtual void nodeSwap(RBNode<Key, Value>* n1, RBNode<Key, Value>* n2);
+
+    // NULL children count as black leaves
+    static bool isRed(RBNode<Key, Value>* n);
+
+    void insertFixup(RBNode<Key, Value>* n);
+    void removeFixup(RBNode<Key, Value>* n, RBNode<Key, Value>* parent, bool isLeft);
+    void rightRotate(RBNode<Key, Value>* z);
+    void leftRotate(RBNode<Key, Value>* z);
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the RedBlackTree class.
+  -----------------------------------------------
+*/
+
+/**
+* Constructs an empty red-black tree.
+*/
+template<class Key, class Value, class Compare>
+RedBlackTree<Key, Value, Compare>::RedBlackTree() : BinarySearchTree<Key, Value, Compare>()
+{
+
+}
+
+/**
+* Constructs an empty red-black tree ordered by the given comparator.
+*/
+template<class Key, class Value, class Compare>
+RedBlackTree<Key, Value, Compare>::RedBlackTree(const Compare& comp) : BinarySearchTree<Key, Value, Compare>(comp)
+{
+
+}
+
+template<class Key, class Value, class Compare>
+bool RedBlackTree<Key, Value, Compare>::isRed(RBNode<Key, Value>* n)
+{
+    return n != NULL && n->isRed();
+}
+
+/**
+* Inserts a red node at the bottom of the tree, or overwrites the value
+* if the key is already present, then repairs any red-red violation.
+*/
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::insert(const std::pair<const Key, Value>& new_item)
+{
+    Node<Key, Value>* parent = NULL;
+    bool goLeft = false;
+    Node<Key, Value>* temp = this->descend(new_item.first, parent, goLeft);
+    if(temp != NULL) {
+        temp->setValue(new_item.second);
+        return;
+    }
+
+    RBNode<Key, Value>* tempParent = static_cast<RBNode<Key, Value>*>(parent);
+    RBNode<Key, Value>* n = new RBNode<Key, Value>(new_item.first, new_item.second, tempParent);
+    if(tempParent == NULL) {
+        this->root_ = n;
+    }
+    else if(goLeft) {
+        tempParent->setLeft(n);
+    }
+    else {
+        tempParent->setRight(n);
+    }
+    this->nodeLinked(n);
+    insertFixup(n);
+}
+
+/**
+* Walks up from a new red node recoloring while its uncle is red. Once
+* the uncle is black one single or double rotation finishes the job.
+*/
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::insertFixup(RBNode<Key, Value>* n)
+{
+    while(isRed(n->getParent())) {
+        RBNode<Key, Value>* parent = n->getParent();
+        RBNode<Key, Value>* grandParent = parent->getParent(); // exists since the root is black
+        if(parent == grandParent->getLeft()) {
+            RBNode<Key, Value>* uncle = grandParent->getRight();
+            if(isRed(uncle)) {
+                parent->setRed(false);
+                uncle->setRed(false);
+                grandParent->setRed(true);
+                n = grandParent;
+                continue;
+            }
+            if(n == parent->getRight()) {
+                leftRotate(parent); // zig-zag becomes zig-zig
+                parent = n;
+            }
+            parent->setRed(false);
+            grandParent->setRed(true);
+            rightRotate(grandParent);
+            break;
+        }
+        else {
+            RBNode<Key, Value>* uncle = grandParent->getLeft();
+            if(isRed(uncle)) {
+                parent->setRed(false);
+                uncle->setRed(false);
+                grandParent->setRed(true);
+                n = grandParent;
+                continue;
+            }
+            if(n == parent->getLeft()) {
+                rightRotate(parent);
+                parent = n;
+            }
+            parent->setRed(false);
+            grandParent->setRed(true);
+            leftRotate(grandParent);
+            break;
+        }
+    }
+    static_cast<RBNode<Key, Value>*>(this->root_)->setRed(false);
+}
+
+/*
+ * Nodes with 2 children are swapped with their predecessor first, as in
+ * the other trees, so the node actually unlinked has at most one child.
+ */
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::removeNode(Node<Key, Value>* temp)
+{
+    RBNode<Key, Value>* n = static_cast<RBNode<Key, Value>*>(temp);
+    if(n->getLeft() != NULL && n->getRight() != NULL) {
+        RBNode<Key, Value>* pred = static_cast<RBNode<Key, Value>*>(BinarySearchTree<Key, Value, Compare>::predecessor(n));
+        nodeSwap(pred, n);
+    }
+
+    RBNode<Key, Value>* parent = n->getParent();
+    RBNode<Key, Value>* kid = (n->getLeft() != NULL) ? n->getLeft() : n->getRight();
+    bool isLeft = (parent != NULL && parent->getLeft() == n);
+
+    if(kid != NULL) {
+        kid->setParent(parent);
+    }
+    if(parent == NULL) {
+        this->root_ = kid;
+    }
+    else if(isLeft) {
+        parent->setLeft(kid);
+    }
+    else {
+        parent->setRight(kid);
+    }
+
+    // removing a black node leaves its side one black short
+    if(!n->isRed()) {
+        if(isRed(kid)) {
+            kid->setRed(false);
+        }
+        else {
+            removeFixup(kid, parent, isLeft);
+        }
+    }
+    this->destroyNode(n);
+}
+
+/**
+* Pushes the missing black up the tree. Recoloring steps move up a
+* level; each of the terminal cases does at most two rotations, plus at
+* most one for a red sibling, so a removal never rotates more than
+* three times.
+*/
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::removeFixup(RBNode<Key, Value>* n, RBNode<Key, Value>* parent, bool isLeft)
+{
+    while(parent != NULL && !isRed(n)) {
+        if(isLeft) {
+            RBNode<Key, Value>* sibling = parent->getRight();
+            if(isRed(sibling)) {
+                sibling->setRed(false);
+                parent->setRed(true);
+                leftRotate(parent);
+                sibling = parent->getRight();
+            }
+            if(!isRed(sibling->getLeft()) && !isRed(sibling->getRight())) {
+                sibling->setRed(true);
+                n = parent;
+                parent = n->getParent();
+                isLeft = (parent != NULL && parent->getLeft() == n);
+                continue;
+            }
+            if(!isRed(sibling->getRight())) {
+                sibling->getLeft()->setRed(false);
+                sibling->setRed(true);
+                rightRotate(sibling);
+                sibling = parent->getRight();
+            }
+            sibling->setRed(parent->isRed());
+            parent->setRed(false);
+            sibling->getRight()->setRed(false);
+            leftRotate(parent);
+            return;
+        }
+        else {
+            RBNode<Key, Value>* sibling = parent->getLeft();
+            if(isRed(sibling)) {
+                sibling->setRed(false);
+                parent->setRed(true);
+                rightRotate(parent);
+                sibling = parent->getLeft();
+            }
+            if(!isRed(sibling->getLeft()) && !isRed(sibling->getRight())) {
+                sibling->setRed(true);
+                n = parent;
+                parent = n->getParent();
+                isLeft = (parent != NULL && parent->getLeft() == n);
+                continue;
+            }
+            if(!isRed(sibling->getLeft())) {
+                sibling->getRight()->setRed(false);
+                sibling->setRed(true);
+                leftRotate(sibling);
+                sibling = parent->getLeft();
+            }
+            sibling->setRed(parent->isRed());
+            parent->setRed(false);
+            sibling->getLeft()->setRed(false);
+            rightRotate(parent);
+            return;
+        }
+    }
+    if(n != NULL) {
+        n->setRed(false);
+    }
+}
+
+// helper function to rotate nodes right: z's left kid y takes z's place
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::rightRotate(RBNode<Key, Value>* z)
+{
+    RBNode<Key, Value>* y = z->getLeft();
+    RBNode<Key, Value>* zigzag = y->getRight();
+    RBNode<Key, Value>* tempGrandParent = z->getParent();
+
+    y->setRight(z);
+    z->setParent(y);
+    z->setLeft(zigzag);
+    if(zigzag != NULL) {
+        zigzag->setParent(z);
+    }
+
+    y->setParent(tempGrandParent);
+    if(tempGrandParent == NULL) {
+        this->root_ = y;
+    }
+    else if(tempGrandParent->getLeft() == z) {
+        tempGrandParent->setLeft(y);
+    }
+    else {
+        tempGrandParent->setRight(y);
+    }
+}
+
+// helper function to rotate nodes left: z's right kid y takes z's place
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::leftRotate(RBNode<Key, Value>* z)
+{
+    RBNode<Key, Value>* y = z->getRight();
+    RBNode<Key, Value>* zagzig = y->getLeft();
+    RBNode<Key, Value>* tempGrandParent = z->getParent();
+
+    y->setLeft(z);
+    z->setParent(y);
+    z->setRight(zagzig);
+    if(zagzig != NULL) {
+        zagzig->setParent(z);
+    }
+
+    y->setParent(tempGrandParent);
+    if(tempGrandParent == NULL) {
+        this->root_ = y;
+    }
+    else if(tempGrandParent->getLeft() == z) {
+        tempGrandParent->setLeft(y);
+    }
+    else {
+        tempGrandParent->setRight(y);
+    }
+}
+
+template<class Key, class Value, class Compare>
+void RedBlackTree<Key, Value, Compare>::nodeSwap(RBNode<Key, Value>* n1, RBNode<Key, Value>* n2)
+{
+    BinarySearchTree<Key, Value, Compare>::nodeSwap(n1, n2);
+    bool tempRed = n1->isRed();
+    n1->setRed(n2->isRed());
+    n2->setRed(tempRed);
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the RedBlackTree class.
+  ---------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef SCAPEGOATBST_H
+#define SCAPEGOATBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "bst.h"
+
+/**
+* A scapegoat tree: a weight-balanced tree that keeps no balance data in
+* its nodes, only the tree's size, which BinarySearchTree counts anyway.
+* It uses plain Nodes, so each node is a byte (plus padding) smaller than
+* an AVLNode and lookups run the ordinary BinarySearchTree code.
+*
+* When an insert lands deeper than log base 1/alpha of the size, the
+* lowest ancestor whose heavier child holds more than alpha of its
+* subtree is the scapegoat, and that subtree is rebuilt perfectly
+* balanced. When removals shrink the tree below alpha of its size at the
+* last full rebuild, the whole tree is rebuilt. Both costs amortize to
+* O(log n) per update. alpha must lie in [0.5, 1); smaller values keep
+* the tree shallower at the cost of more frequent rebuilds.
+*/
+template <class Key, class Value, class Compare = std::less<Key> >
+class ScapegoatTree : public BinarySearchTree<Key, Value, Compare>
+{
+public:
+    ScapegoatTree();
+    explicit ScapegoatTree(double alpha);
+    ScapegoatTree(double alpha, const Compare& comp);
+    ScapegoatTree(const ScapegoatTree& other);
+    ScapegoatTree(ScapegoatTree&& other) noexcept;
+    ScapegoatTree& operator=(const ScapegoatTree& other);
+    ScapegoatTree& operator=(ScapegoatTree&& other) noexcept;
+    void swap(ScapegoatTree& other) noexcept;
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+    virtual void clear();
+
+protected:
+    virtual void removeNode(Node<Key, Value>* n);
+
+    // Largest depth allowed for the current size
+    size_t depthLimit() const;
+    // Counts the nodes in a subtree
+    static size_t subtreeSize(Node<Key, Value>* n);
+    // Rebuilds the subtree rooted at n into a perfectly balanced shape
+    void rebuild(Node<Key, Value>* n);
+
+    double alpha_;
+    size_t maxSize_;    // size when the whole tree was last rebuilt
+    std::vector<Node<Key, Value>*> rebuildBuffer_;   // reused by every rebuild
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the ScapegoatTree class.
+  -----------------------------------------------
+*/
+
+/**
+* Constructs an empty scapegoat tree with alpha = 2/3.
+*/
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>::ScapegoatTree() :
+    BinarySearchTree<Key, Value, Compare>(), alpha_(2.0 / 3.0), maxSize_(0)
+{
+
+}
+
+/**
+* Constructs an empty scapegoat tree with the given alpha.
+*/
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>::ScapegoatTree(double alpha) :
+    BinarySearchTree<Key, Value, Compare>(), alpha_(alpha), maxSize_(0)
+{
+
+}
+
+/**
+* Constructs an empty scapegoat tree with the given alpha and comparator.
+*/
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>::ScapegoatTree(double alpha, const Compare& comp) :
+    BinarySearchTree<Key, Value, Compare>(comp), alpha_(alpha), maxSize_(0)
+{
+
+}
+
+/**
+* Clones other's shape and rebuild threshold. The rebuild buffer is scratch
+* space and is not copied.
+*/
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>::ScapegoatTree(const ScapegoatTree& other) :
+    BinarySearchTree<Key, Value, Compare>(other), alpha_(other.alpha_), maxSize_(other.maxSize_)
+{
+
+}
+
+/**
+* Takes over other's nodes and rebuild threshold, leaving other empty.
+*/
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>::ScapegoatTree(ScapegoatTree&& other) noexcept :
+    BinarySearchTree<Key, Value, Compare>(std::move(other)), alpha_(other.alpha_), maxSize_(other.maxSize_)
+{
+    other.maxSize_ = 0;
+}
+
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>& ScapegoatTree<Key, Value, Compare>::operator=(const ScapegoatTree& other)
+{
+    if(this != &other) {
+        ScapegoatTree<Key, Value, Compare> copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare>
+ScapegoatTree<Key, Value, Compare>& ScapegoatTree<Key, Value, Compare>::operator=(ScapegoatTree&& other) noexcept
+{
+    if(this != &other) {
+        BinarySearchTree<Key, Value, Compare>::operator=(std::move(other));
+        alpha_ = other.alpha_;
+        maxSize_ = other.maxSize_;
+        other.maxSize_ = 0;
+    }
+    return *this;
+}
+
+template<class Key, class Value, class Compare>
+void ScapegoatTree<Key, Value, Compare>::swap(ScapegoatTree& other) noexcept
+{
+    BinarySearchTree<Key, Value, Compare>::swap(other);
+    std::swap(alpha_, other.alpha_);
+    std::swap(maxSize_, other.maxSize_);
+}
+
+/**
+* Removes everything and resets the rebuild threshold.
+*/
+template<class Key, class Value, class Compare>
+void ScapegoatTree<Key, Value, Compare>::clear()
+{
+    BinarySearchTree<Key, Value, Compare>::clear();
+    maxSize_ = 0;
+}
+
+/**
+* floor(log base 1/alpha of size). Since alpha >= 1/2 this is never less
+* than floor(log2(size)), so the logarithm is only computed for inserts
+* that land deeper than that.
+*/
+template<class Key, class Value, class Compare>
+size_t ScapegoatTree<Key, Value, Compare>::depthLimit() const
+{
+    return (size_t)(std::log((double)this->count_) / std::log(1.0 / alpha_));
+}
+
+template<class Key, class Value, class Compare>
+size_t ScapegoatTree<Key, Value, Compare>::subtreeSize(Node<Key, Value>* n)
+{
+    if(n == NULL) {
+        return 0;
+    }
+    size_t count = 0;
+    std::vector<Node<Key, Value>*> stack(1, n);
+    while(!stack.empty()) {
+        Node<Key, Value>* temp = stack.back();
+        stack.pop_back();
+        ++count;
+        if(temp->getLeft() != NULL) {
+            stack.push_back(temp->getLeft());
+        }
+        if(temp->getRight() != NULL) {
+            stack.push_back(temp->getRight());
+        }
+    }
+    return count;
+}
+
+/**
+* Inserts like an unbalanced BST, then, if the new node is too deep,
+* climbs toward the root looking for the scapegoat and rebuilds it.
+* If key is already in the tree its value is overwritten.
+*/
+template<class Key, class Value, class Compare>
+void ScapegoatTree<Key, Value, Compare>::insert(const std::pair<const Key, Value>& new_item)
+{
+    Node<Key, Value>* parent = NULL;
+    bool goLeft = false;
+    Node<Key, Value>* temp = this->descend(new_item.first, parent, goLeft);
+    if(temp != NULL) {
+        temp->setValue(new_item.second);
+        return;
+    }
+
+    Node<Key, Value>* n = new Node<Key, Value>(new_item.first, new_item.second, parent);
+    size_t depth = 0;
+    if(parent == NULL) {
+        this->root_ = n;
+    }
+    else {
+        if(goLeft) {
+            parent->setLeft(n);
+        }
+        else {
+            parent->setRight(n);
+        }
+        for(Node<Key, Value>* p = parent; p != NULL; p = p->getParent()) {
+            ++depth;
+        }
+    }
+    this->nodeLinked(n);
+    if(this->count_ > maxSize_) {
+        maxSize_ = this->count_;
+    }
+
+    // cheap test first: floor(log2(size)) is a lower bound on the limit
+    size_t log2Size = 0;
+    for(size_t s = this->count_; s > 1; s >>= 1) {
+        ++log2Size;
+    }
+    if(depth <= log2Size || depth <= depthLimit()) {
+        return;
+    }
+
+    // walk up keeping the size of the subtree we came from
+    Node<Key, Value>* child = n;
+    size_t childSize = 1;
+    for(Node<Key, Value>* p = parent; p != NULL; p = p->getParent()) {
+        Node<Key, Value>* sibling = (p->getLeft() == child) ? p->getRight() : p->getLeft();
+        size_t total = childSize + subtreeSize(sibling) + 1;
+        if((double)childSize > alpha_ * (double)total) {
+            rebuild(p);
+            return;
+        }
+        child = p;
+        childSize = total;
+    }
+}
+
+/**
+* Removes like an unbalanced BST and rebuilds the whole tree once it
+* has shrunk below alpha of its size at the last full rebuild.
+*/
+template<class Key, class Value, class Compare>
+void ScapegoatTree<Key, Value, Compare>::removeNode(Node<Key, Value>* n)
+{
+    BinarySearchTree<Key, Value, Compare>::removeNode(n);
+    if((double)this->count_ < alpha_ * (double)maxSize_) {
+        if(this->root_ != NULL) {
+            rebuild(this->root_);
+        }
+        maxSize_ = this->count_;
+    }
+}
+
+/**
+* Flattens the subtree into rebuildBuffer_ and relinks it with the
+* median at the top, then hooks the new subtree root back in place.
+*/
+template<class Key, class Value, class Compare>
+void ScapegoatTree<Key, Value, Compare>::rebuild(Node<Key, Value>* n)
+{
+    Node<Key, Value>* parent = n->getParent();
+    bool isLeft = (parent != NULL && parent->getLeft() == n);
+
+    rebuildBuffer_.clear();
+    BinarySearchTree<Key, Value, Compare>::flattenSubtree(n, rebuildBuffer_);
+    Node<Key, Value>* subRoot = BinarySearchTree<Key, Value, Compare>::linkBalanced(rebuildBuffer_, 0, rebuildBuffer_.size(), parent);
+
+    if(parent == NULL) {
+        this->root_ = subRoot;
+    }
+    else if(isLeft) {
+        parent->setLeft(subRoot);
+    }
+    else {
+        parent->setRight(subRoot);
+    }
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the ScapegoatTree class.
+  ---------------------------------------------
+*/
+
+#endif
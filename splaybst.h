@@ -0,0 +1,305 @@
+#ifndef SPLAYBST_H
+#define SPLAYBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include "bst.h"
+
+/**
+* A self-adjusting binary search tree. Every find, insert and remove
+* splays the accessed key to the root with a single top-down pass, so
+* frequently used keys stay near the top and skewed workloads descend
+* only a few levels. It uses the plain Node class since splaying needs
+* no per-node bookkeeping.
+*
+* find() and operator[] splay only when called on a non-const tree;
+* the const versions inherited from BinarySearchTree leave the shape
+* alone.
+*/
+template <class Key, class Value, class Compare = std::less<Key> >
+class SplayTree : public BinarySearchTree<Key, Value, Compare>
+{
+public:
+    typedef typename BinarySearchTree<Key, Value, Compare>::iterator iterator;
+
+    SplayTree();
+    explicit SplayTree(const Compare& comp);
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+    virtual void remove(const Key& key);
+    iterator find(const Key& key);
+    Value& operator[](const Key& key);
+
+    using BinarySearchTree<Key, Value, Compare>::find;
+    using BinarySearchTree<Key, Value, Compare>::remove;
+    using BinarySearchTree<Key, Value, Compare>::operator[];
+
+protected:
+    virtual void removeNode(Node<Key, Value>* n);
+
+    // Splays the subtree rooted at t around key and returns its new root,
+    // which holds key if found is set and otherwise the last node visited.
+    template<typename K>
+    Node<Key, Value>* splay(Node<Key, Value>* t, const K& key, bool& found);
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the SplayTree class.
+  -----------------------------------------------
+*/
+
+/**
+* Constructs an empty splay tree.
+*/
+template<class Key, class Value, class Compare>
+SplayTree<Key, Value, Compare>::SplayTree() : BinarySearchTree<Key, Value, Compare>()
+{
+
+}
+
+/**
+* Constructs an empty splay tree ordered by the given comparator.
+*/
+template<class Key, class Value, class Compare>
+SplayTree<Key, Value, Compare>::SplayTree(const Compare& comp) : BinarySearchTree<Key, Value, Compare>(comp)
+{
+
+}
+
+/**
+* Top-down splay. Nodes we pass that are smaller than key are hung off
+* the right spine of a "left tree", larger ones off the left spine of a
+* "right tree", and zig-zig steps rotate on the way down. When the walk
+* stops, the final node becomes the root with the two side trees
+* reattached beneath it. Parent pointers are set as nodes are linked.
+*/
+template<class Key, class Value, class Compare>
+template<typename K>
+Node<Key, Value>* SplayTree<Key, Value, Compare>::splay(Node<Key, Value>* t, const K& key, bool& found)
+{
+    found = false;
+    if(t == NULL) {
+        return NULL;
+    }
+
+    Node<Key, Value>* leftTreeRoot = NULL;   // everything smaller than key
+    Node<Key, Value>* leftTreeMax = NULL;    // where the next smaller node hangs
+    Node<Key, Value>* rightTreeRoot = NULL;  // everything larger than key
+    Node<Key, Value>* rightTreeMin = NULL;   // where the next larger node hangs
+
+    int cmp = this->compareKeys(key, t->getKey());
+    while(true) {
+        if(cmp < 0) {
+            Node<Key, Value>* l = t->getLeft();
+            if(l == NULL) {
+                break;
+            }
+            cmp = this->compareKeys(key, l->getKey());
+            if(cmp < 0) {
+                // zig-zig: rotate right before linking
+                t->setLeft(l->getRight());
+                if(l->getRight() != NULL) {
+                    l->getRight()->setParent(t);
+                }
+                l->setRight(t);
+                t->setParent(l);
+                t = l;
+                if(t->getLeft() == NULL) {
+                    break;
+                }
+                cmp = this->compareKeys(key, t->getLeft()->getKey());
+            }
+            // link t into the right tree as its new minimum
+            if(rightTreeMin == NULL) {
+                rightTreeRoot = t;
+            }
+            else {
+                rightTreeMin->setLeft(t);
+                t->setParent(rightTreeMin);
+            }
+            rightTreeMin = t;
+            t = t->getLeft();
+        }
+        else if(cmp > 0) {
+            Node<Key, Value>* r = t->getRight();
+            if(r == NULL) {
+                break;
+            }
+            cmp = this->compareKeys(key, r->getKey());
+            if(cmp > 0) {
+                // zag-zag: rotate left before linking
+                t->setRight(r->getLeft());
+                if(r->getLeft() != NULL) {
+                    r->getLeft()->setParent(t);
+                }
+                r->setLeft(t);
+                t->setParent(r);
+                t = r;
+                if(t->getRight() == NULL) {
+                    break;
+                }
+                cmp = this->compareKeys(key, t->getRight()->getKey());
+            }
+            // link t into the left tree as its new maximum
+            if(leftTreeMax == NULL) {
+                leftTreeRoot = t;
+            }
+            else {
+                leftTreeMax->setRight(t);
+                t->setParent(leftTreeMax);
+            }
+            leftTreeMax = t;
+            t = t->getRight();
+        }
+        else {
+            found = true;
+            break;
+        }
+    }
+
+    // reassemble: t's subtrees go to the inner spines of the side trees
+    if(leftTreeMax != NULL) {
+        leftTreeMax->setRight(t->getLeft());
+        if(t->getLeft() != NULL) {
+            t->getLeft()->setParent(leftTreeMax);
+        }
+        t->setLeft(leftTreeRoot);
+        leftTreeRoot->setParent(t);
+    }
+    if(rightTreeMin != NULL) {
+        rightTreeMin->setLeft(t->getRight());
+        if(t->getRight() != NULL) {
+            t->getRight()->setParent(rightTreeMin);
+        }
+        t->setRight(rightTreeRoot);
+        rightTreeRoot->setParent(t);
+    }
+    t->setParent(NULL);
+    return t;
+}
+
+/**
+* Splays the key to the root and, if it is not already there, makes
+* the new node the root with the old tree split beneath it.
+* If key is already in the tree its value is overwritten.
+*/
+template<class Key, class Value, class Compare>
+void SplayTree<Key, Value, Compare>::insert(const std::pair<const Key, Value>& new_item)
+{
+    bool found = false;
+    Node<Key, Value>* oldRoot = splay(this->root_, new_item.first, found);
+    this->root_ = oldRoot;
+    if(found) {
+        oldRoot->setValue(new_item.second);
+        return;
+    }
+
+    Node<Key, Value>* n = new Node<Key, Value>(new_item.first, new_item.second, NULL);
+    if(oldRoot != NULL) {
+        if(this->comp_(new_item.first, oldRoot->getKey())) {
+            // oldRoot and its right subtree are larger than the new key
+            n->setLeft(oldRoot->getLeft());
+            n->setRight(oldRoot);
+            oldRoot->setLeft(NULL);
+        }
+        else {
+            n->setRight(oldRoot->getRight());
+            n->setLeft(oldRoot);
+            oldRoot->setRight(NULL);
+        }
+        if(n->getLeft() != NULL) {
+            n->getLeft()->setParent(n);
+        }
+        if(n->getRight() != NULL) {
+            n->getRight()->setParent(n);
+        }
+    }
+    this->root_ = n;
+    this->nodeLinked(n);
+}
+
+/**
+* Splays the key to the root and removes it if it is there.
+*/
+template<class Key, class Value, class Compare>
+void SplayTree<Key, Value, Compare>::remove(const Key& key)
+{
+    bool found = false;
+    this->root_ = splay(this->root_, key, found);
+    if(found) {
+        removeNode(this->root_);
+        this->refreshEnds();
+    }
+}
+
+/**
+* Splays n to the root, then joins its subtrees by splaying the largest
+* key of the left subtree to that subtree's root and hanging the right
+* subtree off it.
+*/
+template<class Key, class Value, class Compare>
+void SplayTree<Key, Value, Compare>::removeNode(Node<Key, Value>* n)
+{
+    bool found = false;
+    if(n != this->root_) {
+        this->root_ = splay(this->root_, n->getKey(), found);
+    }
+
+    Node<Key, Value>* left = n->getLeft();
+    Node<Key, Value>* right = n->getRight();
+    if(left == NULL) {
+        this->root_ = right;
+        if(right != NULL) {
+            right->setParent(NULL);
+        }
+    }
+    else {
+        left->setParent(NULL);
+        // every key in the left subtree is smaller, so this brings its max up
+        Node<Key, Value>* newRoot = splay(left, n->getKey(), found);
+        newRoot->setRight(right);
+        if(right != NULL) {
+            right->setParent(newRoot);
+        }
+        this->root_ = newRoot;
+    }
+    this->destroyNode(n);
+}
+
+/**
+* Returns an iterator to the item with the given key, splaying it
+* (or the last node visited, if it is missing) to the root.
+*/
+template<class Key, class Value, class Compare>
+typename SplayTree<Key, Value, Compare>::iterator
+SplayTree<Key, Value, Compare>::find(const Key& key)
+{
+    bool found = false;
+    this->root_ = splay(this->root_, key, found);
+    if(!found) {
+        return this->end();
+    }
+    return this->iteratorAt(this->root_);
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key, splaying it to the root
+ */
+template<class Key, class Value, class Compare>
+Value& SplayTree<Key, Value, Compare>::operator[](const Key& key)
+{
+    bool found = false;
+    this->root_ = splay(this->root_, key, found);
+    if(!found) throw std::out_of_range("Invalid key");
+    return this->root_->getValue();
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the SplayTree class.
+  ---------------------------------------------
+*/
+
+#endif
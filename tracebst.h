@@ -0,0 +1,421 @@
+#ifndef TRACEBST_H
+#define TRACEBST_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <vector>
+#include <type_traits>
+#include "avlbst.h"
+
+/*
+ * Operation traces. A trace is a compact binary log of the inserts,
+ * removes, finds and full iterations a tree saw, which bst-replay can run
+ * against any engine to reproduce a production access pattern.
+ *
+ * Format: the 8 bytes "BSTTRC1\n", one byte giving the key kind ('i' for
+ * integers, 's' for strings), then one record per operation: a byte
+ * holding the TraceOp and, for every op but TRACE_ITERATE, the key.
+ * Integer keys are stored as the zigzag varint of their difference from
+ * the previous key, so sequential and clustered keys take a byte or two;
+ * string keys as a varint length and the bytes. Values are not recorded:
+ * they don't change what the tree does, so replay inserts a default one.
+ */
+
+enum TraceOp
+{
+    TRACE_INSERT = 1,
+    TRACE_REMOVE = 2,
+    TRACE_FIND = 3,
+    TRACE_ITERATE = 4
+};
+
+/**
+* How each kind of key goes into a trace. Integral keys and std::string
+* are supported; the primary template is left undefined so other key
+* types fail to compile rather than record garbage.
+*/
+template<typename Key, typename Enable = void>
+struct TraceKeyCodec;
+
+/**
+* Reading and writing the varints and the header shared by every codec.
+*/
+class TraceIO
+{
+public:
+    static void writeVarint(std::vector<char>& out, uint64_t v);
+    static uint64_t readVarint(std::istream& in);
+    static void writeHeader(std::ostream& out, char kind);
+    // Reads the header and returns the key kind; throws
+    // std::runtime_error if the stream isn't a trace.
+    static char readHeader(std::istream& in);
+};
+
+template<typename Key>
+struct TraceKeyCodec<Key, typename std::enable_if<std::is_integral<Key>::value>::type>
+{
+    static const char kind = 'i';
+
+    TraceKeyCodec() : prev_(0) {}
+    void write(std::vector<char>& out, const Key& key)
+    {
+        int64_t delta = (int64_t)((uint64_t)(int64_t)key - (uint64_t)prev_);
+        prev_ = (int64_t)key;
+        TraceIO::writeVarint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    }
+    Key read(std::istream& in)
+    {
+        uint64_t zigzag = TraceIO::readVarint(in);
+        int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+        prev_ = (int64_t)((uint64_t)prev_ + (uint64_t)delta);
+        return (Key)prev_;
+    }
+
+private:
+    int64_t prev_;
+};
+
+template<>
+struct TraceKeyCodec<std::string>
+{
+    static const char kind = 's';
+
+    void write(std::vector<char>& out, const std::string& key)
+    {
+        TraceIO::writeVarint(out, key.size());
+        out.insert(out.end(), key.begin(), key.end());
+    }
+    std::string read(std::istream& in)
+    {
+        std::string key((size_t)TraceIO::readVarint(in), '\0');
+        if(!in.read(&key[0], key.size())) {
+            throw std::runtime_error("Truncated trace");
+        }
+        return key;
+    }
+};
+
+/**
+* Writes trace records to a stream. The stream should be opened in
+* binary mode and must outlive the writer. Records collect in a 64 KB
+* buffer that goes to the stream when it fills and when the writer is
+* destroyed, so recording costs a few stores per op rather than a
+* stream call.
+*/
+template<typename Key>
+class TraceWriter
+{
+public:
+    explicit TraceWriter(std::ostream& out);
+    ~TraceWriter();
+    void record(TraceOp op, const Key& key);
+    void recordIterate();
+    void flush();
+
+private:
+    TraceWriter(const TraceWriter&);
+    TraceWriter& operator=(const TraceWriter&);
+
+    std::ostream& out_;
+    std::vector<char> buffer_;
+    TraceKeyCodec<Key> codec_;
+};
+
+/**
+* Reads trace records back. The key kind in the header has to match Key.
+*/
+template<typename Key>
+class TraceReader
+{
+public:
+    explicit TraceReader(std::istream& in);
+    // Reads the next record into op and key (key is left alone for
+    // TRACE_ITERATE). Returns false at the end of the trace and throws
+    // std::runtime_error on a damaged one.
+    bool next(TraceOp& op, Key& key);
+
+private:
+    std::istream& in_;
+    TraceKeyCodec<Key> codec_;
+};
+
+/**
+* A tree that can log what is done to it. Tree is any engine from the
+* BinarySearchTree family (AVLTree by default); nothing is recorded
+* until startTrace().
+*
+* insert, remove (by key or through erase) and find(key) are recorded
+* with their keys, and begin() as a full iteration. Lookups through
+* count, contains, operator[] and the heterogeneous overloads are not.
+* Copies of a traced tree start out untraced.
+*/
+template<typename Key, typename Value, typename Tree = AVLTree<Key, Value> >
+class TracedTree : public Tree
+{
+public:
+    typedef typename Tree::iterator iterator;
+
+    using Tree::Tree;
+    TracedTree() : Tree() {}
+    TracedTree(const TracedTree& other) : Tree(other) {}
+    TracedTree(TracedTree&& other) = default;
+    TracedTree& operator=(const TracedTree& other);
+    TracedTree& operator=(TracedTree&& other) = default;
+
+    // Starts logging to out, which must outlive the trace. Replaces any
+    // trace already running.
+    void startTrace(std::ostream& out);
+    void stopTrace();
+    bool tracing() const;
+
+    virtual void insert(const std::pair<const Key, Value>& keyValuePair) override;
+    virtual void remove(const Key& key) override;
+    using Tree::remove;
+    // Both constnesses, so engines whose non-const find does more (the
+    // splay tree splays) still do it
+    iterator find(const Key& key);
+    iterator find(const Key& key) const;
+    using Tree::find;
+    iterator begin() const;
+    iterator erase(iterator pos);
+    iterator erase(iterator first, iterator last);
+
+private:
+    std::unique_ptr<TraceWriter<Key> > trace_;
+};
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the TraceIO class.
+  ----------------------------------------------------
+*/
+
+inline void TraceIO::writeVarint(std::vector<char>& out, uint64_t v)
+{
+    while(v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+inline uint64_t TraceIO::readVarint(std::istream& in)
+{
+    uint64_t v = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if(c == std::char_traits<char>::eof()) {
+            throw std::runtime_error("Truncated trace");
+        }
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if((c & 0x80) == 0) {
+            return v;
+        }
+    }
+    throw std::runtime_error("Bad varint in trace");
+}
+
+inline void TraceIO::writeHeader(std::ostream& out, char kind)
+{
+    out.write("BSTTRC1\n", 8);
+    out.put(kind);
+}
+
+inline char TraceIO::readHeader(std::istream& in)
+{
+    char magic[8];
+    if(!in.read(magic, 8) || std::memcmp(magic, "BSTTRC1\n", 8) != 0) {
+        throw std::runtime_error("Not a tree trace");
+    }
+    int kind = in.get();
+    if(kind != 'i' && kind != 's') {
+        throw std::runtime_error("Unknown key kind in trace");
+    }
+    return (char)kind;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the TraceIO class.
+  ----------------------------------------------------
+*/
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the TraceWriter and TraceReader classes.
+  ----------------------------------------------------
+*/
+
+template<typename Key>
+TraceWriter<Key>::TraceWriter(std::ostream& out) : out_(out)
+{
+    TraceIO::writeHeader(out_, TraceKeyCodec<Key>::kind);
+    buffer_.reserve(1 << 16);
+}
+
+template<typename Key>
+TraceWriter<Key>::~TraceWriter()
+{
+    flush();
+}
+
+template<typename Key>
+void TraceWriter<Key>::record(TraceOp op, const Key& key)
+{
+    buffer_.push_back((char)op);
+    codec_.write(buffer_, key);
+    if(buffer_.size() >= (1 << 16) - 16) {
+        flush();
+    }
+}
+
+template<typename Key>
+void TraceWriter<Key>::recordIterate()
+{
+    buffer_.push_back((char)TRACE_ITERATE);
+    if(buffer_.size() >= (1 << 16) - 16) {
+        flush();
+    }
+}
+
+template<typename Key>
+void TraceWriter<Key>::flush()
+{
+    out_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+template<typename Key>
+TraceReader<Key>::TraceReader(std::istream& in) : in_(in)
+{
+    if(TraceIO::readHeader(in_) != TraceKeyCodec<Key>::kind) {
+        throw std::runtime_error("Trace key kind doesn't match the key type");
+    }
+}
+
+template<typename Key>
+bool TraceReader<Key>::next(TraceOp& op, Key& key)
+{
+    int c = in_.get();
+    if(c == std::char_traits<char>::eof()) {
+        return false;
+    }
+    if(c < TRACE_INSERT || c > TRACE_ITERATE) {
+        throw std::runtime_error("Bad operation in trace");
+    }
+    op = (TraceOp)c;
+    if(op != TRACE_ITERATE) {
+        key = codec_.read(in_);
+    }
+    return true;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the TraceWriter and TraceReader classes.
+  ----------------------------------------------------
+*/
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the TracedTree class.
+  ----------------------------------------------------
+*/
+
+/**
+* Copies the tree but not the trace: the copy starts out untraced.
+*/
+template<typename Key, typename Value, typename Tree>
+TracedTree<Key, Value, Tree>& TracedTree<Key, Value, Tree>::operator=(const TracedTree& other)
+{
+    Tree::operator=(other);
+    return *this;
+}
+
+template<typename Key, typename Value, typename Tree>
+void TracedTree<Key, Value, Tree>::startTrace(std::ostream& out)
+{
+    trace_.reset(new TraceWriter<Key>(out));
+}
+
+template<typename Key, typename Value, typename Tree>
+void TracedTree<Key, Value, Tree>::stopTrace()
+{
+    trace_.reset();
+}
+
+template<typename Key, typename Value, typename Tree>
+bool TracedTree<Key, Value, Tree>::tracing() const
+{
+    return trace_ != nullptr;
+}
+
+template<typename Key, typename Value, typename Tree>
+void TracedTree<Key, Value, Tree>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    if(trace_) trace_->record(TRACE_INSERT, keyValuePair.first);
+    Tree::insert(keyValuePair);
+}
+
+template<typename Key, typename Value, typename Tree>
+void TracedTree<Key, Value, Tree>::remove(const Key& key)
+{
+    if(trace_) trace_->record(TRACE_REMOVE, key);
+    Tree::remove(key);
+}
+
+template<typename Key, typename Value, typename Tree>
+typename TracedTree<Key, Value, Tree>::iterator TracedTree<Key, Value, Tree>::find(const Key& key)
+{
+    if(trace_) trace_->record(TRACE_FIND, key);
+    return Tree::find(key);
+}
+
+template<typename Key, typename Value, typename Tree>
+typename TracedTree<Key, Value, Tree>::iterator TracedTree<Key, Value, Tree>::find(const Key& key) const
+{
+    if(trace_) trace_->record(TRACE_FIND, key);
+    return Tree::find(key);
+}
+
+template<typename Key, typename Value, typename Tree>
+typename TracedTree<Key, Value, Tree>::iterator TracedTree<Key, Value, Tree>::begin() const
+{
+    if(trace_) trace_->recordIterate();
+    return Tree::begin();
+}
+
+template<typename Key, typename Value, typename Tree>
+typename TracedTree<Key, Value, Tree>::iterator TracedTree<Key, Value, Tree>::erase(iterator pos)
+{
+    if(trace_) trace_->record(TRACE_REMOVE, pos->first);
+    return Tree::erase(pos);
+}
+
+/**
+* A range erase is recorded as one remove per key, so replaying it costs
+* what removing the keys one by one would.
+*/
+template<typename Key, typename Value, typename Tree>
+typename TracedTree<Key, Value, Tree>::iterator TracedTree<Key, Value, Tree>::erase(iterator first, iterator last)
+{
+    if(trace_) {
+        for(iterator it = first; it != last; ++it) {
+            trace_->record(TRACE_REMOVE, it->first);
+        }
+    }
+    return Tree::erase(first, last);
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the TracedTree class.
+  ----------------------------------------------------
+*/
+
+#endif
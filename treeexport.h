@@ -0,0 +1,393 @@
+#ifndef TREEEXPORT_H
+#define TREEEXPORT_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <random>
+#include <utility>
+#include <type_traits>
+#include "treeshape.h"
+
+/*
+ * Streaming export of a tree as Graphviz DOT or JSON. Nodes are written
+ * as they are reached in one preorder pass, so a tree of any size takes
+ * O(n) time and only O(h) memory for the walk; nothing is buffered.
+ *
+ * DOT draws each node as "key: value" with edges labelled L or R. JSON
+ * is one object with a "nodes" array, one node per line, each naming its
+ * parent:
+ *   {"id":1,"parent":0,"side":"L","depth":1,"key":3,"value":"leo"}
+ */
+
+enum TreeExportFormat
+{
+    TREE_DOT,
+    TREE_JSON
+};
+
+/**
+* Which part of the tree to write. By default, every node.
+*/
+struct TreeExportOptions
+{
+    TreeExportOptions() : maxDepth(-1), sampleEvery(1), seed(1), values(true) {}
+
+    // Stop after this many levels below the export root (0 writes the
+    // root alone); -1 for no limit. A node whose children were cut off is
+    // marked: a "..." stub in DOT, "more":true in JSON.
+    int maxDepth;
+    // Keep about one node in sampleEvery, picked at random with seed; the
+    // export root is always kept. A kept node hangs off its nearest kept
+    // ancestor: DOT dashes the edge and labels it with the levels skipped,
+    // JSON shows the gap in "depth".
+    size_t sampleEvery;
+    unsigned seed;
+    // Write values as well as keys, for nodes that have them
+    bool values;
+};
+
+/**
+* Writes the tree rooted at root to out. Works on any node type
+* ShapeLinks can walk; labels use getKey()/getValue() when the node has
+* them and a key member otherwise.
+*/
+template<typename NodeT>
+void exportTree(std::ostream& out, const NodeT* root, TreeExportFormat format,
+                const TreeExportOptions& options = TreeExportOptions());
+
+/**
+* The single pass behind exportTree().
+*/
+template<typename NodeT>
+class TreeExporter
+{
+public:
+    TreeExporter(std::ostream& out, TreeExportFormat format, const TreeExportOptions& options);
+    void write(const NodeT* root);
+
+protected:
+    // One node still to visit: the nearest kept ancestor, which side of
+    // it the path down started on, and how many levels were skipped
+    struct Pending
+    {
+        const NodeT* node;
+        int depth;
+        long long parent;   // -1 for the export root
+        char side;
+        int skipped;
+    };
+
+    bool keep(const Pending& p);
+    void writeNode(long long id, const Pending& p, bool more);
+
+    // Labels: key and value through the node's getters when it has them
+    template<typename N>
+    static auto writeKey(std::ostream& out, const N* n, bool json, int) -> decltype(n->getKey(), void());
+    template<typename N>
+    static void writeKey(std::ostream& out, const N* n, bool json, long);
+    // writeValue puts prefix first, or writes nothing for a node without a value
+    template<typename N>
+    static auto writeValue(std::ostream& out, const N* n, const char* prefix, bool json, int) -> decltype(n->getValue(), void());
+    template<typename N>
+    static void writeValue(std::ostream& out, const N* n, const char* prefix, bool json, long);
+
+    std::ostream& out_;
+    TreeExportFormat format_;
+    TreeExportOptions options_;
+    std::minstd_rand rng_;
+    bool firstNode_;
+};
+
+/*
+ * Label formatting. Numbers go out as they are; everything else is
+ * printed through operator<< (or as <?> when there is none) and escaped,
+ * and quoted for JSON. Pairs print as (first, second) in DOT and as a
+ * two-element array in JSON.
+ */
+
+inline void exportEscaped(std::ostream& out, char c, bool json)
+{
+    if(c == '"' || c == '\\') {
+        out << '\\' << c;
+    }
+    else if(c == '\n') {
+        out << "\\n";
+    }
+    else if((unsigned char)c < 0x20) {
+        if(json) {
+            static const char hex[] = "0123456789abcdef";
+            out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        }
+        else {
+            out << ' ';
+        }
+    }
+    else {
+        out << c;
+    }
+}
+
+inline void exportEscaped(std::ostream& out, const std::string& s, bool json)
+{
+    if(json) out << '"';
+    for(size_t i = 0; i < s.size(); ++i) {
+        exportEscaped(out, s[i], json);
+    }
+    if(json) out << '"';
+}
+
+/**
+* A stream buffer that escapes each character on its way to another
+* stream, so operator<< output can be escaped without building a string
+* first. (The test harness includes bst.h with private defined as
+* public, which <sstream> does not survive.)
+*/
+class ExportEscapeBuffer : public std::streambuf
+{
+public:
+    ExportEscapeBuffer(std::ostream& out, bool json) : out_(out), json_(json) {}
+protected:
+    int overflow(int c)
+    {
+        if(c != traits_type::eof()) {
+            exportEscaped(out_, (char)c, json_);
+        }
+        return traits_type::not_eof(c);
+    }
+private:
+    std::ostream& out_;
+    bool json_;
+};
+
+template<typename T>
+auto exportText(std::ostream& out, const T& v, bool json, int) -> decltype(out << v, void())
+{
+    ExportEscapeBuffer escaper(out, json);
+    std::ostream text(&escaper);
+    if(json) out << '"';
+    text << v;
+    if(json) out << '"';
+}
+
+template<typename T>
+void exportText(std::ostream& out, const T&, bool json, long)
+{
+    exportEscaped(out, "<?>", json);
+}
+
+template<typename T>
+void exportLabel(std::ostream& out, const T& v, bool, std::true_type)
+{
+    out << +v;
+}
+
+template<typename T>
+void exportLabel(std::ostream& out, const T& v, bool json, std::false_type)
+{
+    exportText(out, v, json, 0);
+}
+
+template<typename T>
+void exportLabel(std::ostream& out, const T& v, bool json)
+{
+    // char prints as a character, so it goes the text way
+    exportLabel(out, v, json, std::integral_constant<bool, std::is_arithmetic<T>::value &&
+                !std::is_same<T, char>::value && !std::is_same<T, bool>::value>());
+}
+
+inline void exportLabel(std::ostream& out, const bool& v, bool)
+{
+    out << (v ? "true" : "false");
+}
+
+inline void exportLabel(std::ostream& out, const std::string& v, bool json)
+{
+    exportEscaped(out, v, json);
+}
+
+template<typename A, typename B>
+void exportLabel(std::ostream& out, const std::pair<A, B>& v, bool json)
+{
+    out << (json ? "[" : "(");
+    exportLabel(out, v.first, json);
+    out << ", ";
+    exportLabel(out, v.second, json);
+    out << (json ? "]" : ")");
+}
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the TreeExporter class.
+  ----------------------------------------------------
+*/
+
+template<typename NodeT>
+TreeExporter<NodeT>::TreeExporter(std::ostream& out, TreeExportFormat format, const TreeExportOptions& options) :
+    out_(out), format_(format), options_(options), rng_(options.seed), firstNode_(true)
+{
+}
+
+/**
+* Writes the whole export, header to footer, in one preorder walk.
+*/
+template<typename NodeT>
+void TreeExporter<NodeT>::write(const NodeT* root)
+{
+    if(format_ == TREE_DOT) {
+        out_ << "digraph tree {\n  node [shape=box, fontname=\"monospace\"];\n";
+    }
+    else {
+        out_ << "{\"nodes\":[";
+    }
+
+    std::vector<Pending> pending;
+    pending.reserve(64);
+    if(root != nullptr) {
+        Pending top = { root, 0, -1, 0, 0 };
+        pending.push_back(top);
+    }
+    long long nextId = 0;
+    while(!pending.empty()) {
+        Pending p = pending.back();
+        pending.pop_back();
+        const NodeT* left = ShapeLinks<NodeT>::left(p.node);
+        const NodeT* right = ShapeLinks<NodeT>::right(p.node);
+        bool atLimit = options_.maxDepth >= 0 && p.depth >= options_.maxDepth;
+
+        // children of a kept node hang off it; children of a skipped one
+        // hang off the same ancestor it would have, one more level down
+        Pending child = p;
+        if(keep(p)) {
+            long long id = nextId++;
+            writeNode(id, p, atLimit && (left != nullptr || right != nullptr));
+            child.parent = id;
+            child.side = 0;
+            child.skipped = 0;
+        }
+        else {
+            ++child.skipped;
+        }
+        if(atLimit) {
+            continue;
+        }
+        ++child.depth;
+        // right goes on first so the left subtree comes out first
+        if(right != nullptr) {
+            child.node = right;
+            if(child.skipped == 0) child.side = 'R';
+            pending.push_back(child);
+        }
+        if(left != nullptr) {
+            child.node = left;
+            if(child.skipped == 0) child.side = 'L';
+            pending.push_back(child);
+        }
+    }
+
+    if(format_ == TREE_DOT) {
+        out_ << "}\n";
+    }
+    else {
+        out_ << (firstNode_ ? "]}\n" : "\n]}\n");
+    }
+}
+
+template<typename NodeT>
+bool TreeExporter<NodeT>::keep(const Pending& p)
+{
+    if(p.parent < 0 || options_.sampleEvery <= 1) {
+        return true;
+    }
+    return rng_() % options_.sampleEvery == 0;
+}
+
+template<typename NodeT>
+void TreeExporter<NodeT>::writeNode(long long id, const Pending& p, bool more)
+{
+    if(format_ == TREE_DOT) {
+        out_ << "  n" << id << " [label=\"";
+        writeKey(out_, p.node, false, 0);
+        if(options_.values) {
+            writeValue(out_, p.node, ": ", false, 0);
+        }
+        out_ << "\"];\n";
+        if(p.parent >= 0) {
+            out_ << "  n" << p.parent << " -> n" << id << " [label=\"" << p.side;
+            if(p.skipped > 0) {
+                out_ << " +" << p.skipped << "\", style=dashed";
+            }
+            else {
+                out_ << '"';
+            }
+            out_ << "];\n";
+        }
+        if(more) {
+            out_ << "  m" << id << " [label=\"...\", shape=plaintext];\n"
+                 << "  n" << id << " -> m" << id << " [style=dotted];\n";
+        }
+        return;
+    }
+
+    out_ << (firstNode_ ? "\n" : ",\n") << "{\"id\":" << id << ",\"parent\":";
+    firstNode_ = false;
+    if(p.parent >= 0) {
+        out_ << p.parent << ",\"side\":\"" << p.side << '"';
+    }
+    else {
+        out_ << "null,\"side\":null";
+    }
+    out_ << ",\"depth\":" << p.depth << ",\"key\":";
+    writeKey(out_, p.node, true, 0);
+    if(options_.values) {
+        writeValue(out_, p.node, ",\"value\":", true, 0);
+    }
+    if(more) {
+        out_ << ",\"more\":true";
+    }
+    out_ << '}';
+}
+
+template<typename NodeT>
+template<typename N>
+auto TreeExporter<NodeT>::writeKey(std::ostream& out, const N* n, bool json, int) -> decltype(n->getKey(), void())
+{
+    exportLabel(out, n->getKey(), json);
+}
+
+template<typename NodeT>
+template<typename N>
+void TreeExporter<NodeT>::writeKey(std::ostream& out, const N* n, bool json, long)
+{
+    exportLabel(out, n->key, json);
+}
+
+template<typename NodeT>
+template<typename N>
+auto TreeExporter<NodeT>::writeValue(std::ostream& out, const N* n, const char* prefix, bool json, int) -> decltype(n->getValue(), void())
+{
+    out << prefix;
+    exportLabel(out, n->getValue(), json);
+}
+
+template<typename NodeT>
+template<typename N>
+void TreeExporter<NodeT>::writeValue(std::ostream&, const N*, const char*, bool, long)
+{
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the TreeExporter class.
+  ----------------------------------------------------
+*/
+
+template<typename NodeT>
+void exportTree(std::ostream& out, const NodeT* root, TreeExportFormat format, const TreeExportOptions& options)
+{
+    TreeExporter<NodeT> exporter(out, format, options);
+    exporter.write(root);
+}
+
+#endif
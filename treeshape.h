@@ -0,0 +1,247 @@
+#ifndef TREESHAPE_H
+#define TREESHAPE_H
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "workpool.h"
+
+/**
+* How treeShape() reaches a node's children. Nodes with getLeft() and
+* getRight() (the BinarySearchTree family) use those; plain structs with
+* left and right members (the equal-paths Node) use the members. Other
+* node layouts can specialize this.
+*/
+template<typename NodeT>
+struct ShapeLinks
+{
+    static const NodeT* left(const NodeT* n) { return pick(n, 0, true); }
+    static const NodeT* right(const NodeT* n) { return pick(n, 0, false); }
+
+private:
+    template<typename N>
+    static auto pick(const N* n, int, bool left) -> decltype(n->getLeft(), (const NodeT*)0)
+    {
+        return left ? n->getLeft() : n->getRight();
+    }
+    template<typename N>
+    static const NodeT* pick(const N* n, long, bool left)
+    {
+        return left ? n->left : n->right;
+    }
+};
+
+/**
+* The shape of a binary tree, gathered in one pass: node and leaf counts,
+* height, the shallowest and deepest leaf, and per-depth histograms of
+* leaves and of all nodes. Depths count edges from the root, so the root
+* is at depth 0; height counts levels, so an empty tree has height 0.
+*/
+struct TreeShape
+{
+    TreeShape();
+
+    size_t nodes;
+    size_t leaves;
+    int height;
+    int minLeafDepth;               // -1 for an empty tree
+    int maxLeafDepth;               // -1 for an empty tree
+    std::vector<size_t> leafDepths;   // leafDepths[d] leaves sit at depth d
+    std::vector<size_t> levelWidths;  // levelWidths[d] nodes sit at depth d
+
+    // True when every leaf is at the same depth, as equalPaths() checks
+    bool equalPaths() const;
+
+    // Adds the subtree rooted at n, whose root sits at the given depth,
+    // without recursion.
+    template<typename NodeT>
+    void addSubtree(const NodeT* n, int depth);
+    // Counts one node at the given depth.
+    void addNode(int depth, bool leaf);
+    // Adds the counts of a shape taken from a disjoint part of the tree.
+    void merge(const TreeShape& other);
+};
+
+/**
+* Measures the tree rooted at root in a single depth-first pass.
+*
+* With threads > 1 (0 means one per hardware thread) the top of the tree
+* is opened level by level until there are about 8 subtrees per thread,
+* and those subtrees are measured on a WorkStealingPool and merged. Only
+* worth it for trees of hundreds of thousands of nodes or more; a tree
+* that runs out of nodes before the split is finished serially.
+*/
+template<typename NodeT>
+TreeShape treeShape(const NodeT* root, unsigned threads = 1);
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the TreeShape class.
+  ----------------------------------------------------
+*/
+
+inline TreeShape::TreeShape() :
+    nodes(0), leaves(0), height(0), minLeafDepth(-1), maxLeafDepth(-1)
+{
+}
+
+inline bool TreeShape::equalPaths() const
+{
+    return minLeafDepth == maxLeafDepth;
+}
+
+inline void TreeShape::addNode(int depth, bool leaf)
+{
+    if(depth >= height) {
+        height = depth + 1;
+        levelWidths.resize(height, 0);
+    }
+    ++nodes;
+    ++levelWidths[depth];
+    if(leaf) {
+        if(depth >= (int)leafDepths.size()) {
+            leafDepths.resize(depth + 1, 0);
+        }
+        ++leaves;
+        ++leafDepths[depth];
+        if(minLeafDepth < 0 || depth < minLeafDepth) {
+            minLeafDepth = depth;
+        }
+        if(depth > maxLeafDepth) {
+            maxLeafDepth = depth;
+        }
+    }
+}
+
+template<typename NodeT>
+void TreeShape::addSubtree(const NodeT* n, int depth)
+{
+    if(n == nullptr) {
+        return;
+    }
+    // go left and keep the right children to come back for, so a chain
+    // a million levels deep only ever has a couple of entries here
+    std::vector<std::pair<const NodeT*, int> > pending;
+    pending.reserve(64);
+    while(true) {
+        const NodeT* left = ShapeLinks<NodeT>::left(n);
+        const NodeT* right = ShapeLinks<NodeT>::right(n);
+        addNode(depth, left == nullptr && right == nullptr);
+        ++depth;
+        if(left != nullptr) {
+            if(right != nullptr) {
+                pending.push_back(std::make_pair(right, depth));
+            }
+            n = left;
+        }
+        else if(right != nullptr) {
+            n = right;
+        }
+        else if(pending.empty()) {
+            break;
+        }
+        else {
+            n = pending.back().first;
+            depth = pending.back().second;
+            pending.pop_back();
+        }
+    }
+}
+
+inline void TreeShape::merge(const TreeShape& other)
+{
+    if(other.nodes == 0) {
+        return;
+    }
+    nodes += other.nodes;
+    leaves += other.leaves;
+    if(other.height > height) {
+        height = other.height;
+        levelWidths.resize(height, 0);
+    }
+    for(size_t d = 0; d < other.levelWidths.size(); ++d) {
+        levelWidths[d] += other.levelWidths[d];
+    }
+    if(other.leafDepths.size() > leafDepths.size()) {
+        leafDepths.resize(other.leafDepths.size(), 0);
+    }
+    for(size_t d = 0; d < other.leafDepths.size(); ++d) {
+        leafDepths[d] += other.leafDepths[d];
+    }
+    if(other.minLeafDepth >= 0 && (minLeafDepth < 0 || other.minLeafDepth < minLeafDepth)) {
+        minLeafDepth = other.minLeafDepth;
+    }
+    if(other.maxLeafDepth > maxLeafDepth) {
+        maxLeafDepth = other.maxLeafDepth;
+    }
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the TreeShape class.
+  ----------------------------------------------------
+*/
+
+template<typename NodeT>
+TreeShape treeShape(const NodeT* root, unsigned threads)
+{
+    TreeShape shape;
+    if(threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if(threads <= 1 || root == nullptr) {
+        shape.addSubtree(root, 0);
+        return shape;
+    }
+
+    // Count the top levels here, breadth first, until the level below is
+    // wide enough to hand out. A chain never gets wide, so give up after
+    // a few dozen levels and let one task take the rest.
+    std::vector<const NodeT*> frontier(1, root);
+    std::vector<const NodeT*> next;
+    int depth = 0;
+    while(frontier.size() < 8 * (size_t)threads && depth < 64) {
+        next.clear();
+        for(size_t i = 0; i < frontier.size(); ++i) {
+            const NodeT* left = ShapeLinks<NodeT>::left(frontier[i]);
+            const NodeT* right = ShapeLinks<NodeT>::right(frontier[i]);
+            shape.addNode(depth, left == nullptr && right == nullptr);
+            if(left != nullptr) next.push_back(left);
+            if(right != nullptr) next.push_back(right);
+        }
+        if(next.empty()) {
+            return shape;
+        }
+        frontier.swap(next);
+        ++depth;
+    }
+
+    std::vector<TreeShape> parts(frontier.size());
+    std::atomic<size_t> remaining(frontier.size());
+    std::atomic<bool> done(false);
+    WorkStealingPool pool(threads);
+    for(size_t i = 0; i < frontier.size(); ++i) {
+        pool.spawn([&, i]() {
+            try {
+                parts[i].addSubtree(frontier[i], depth);
+            }
+            catch(...) {
+                pool.fail(std::current_exception());
+            }
+            if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                done.store(true, std::memory_order_release);
+            }
+        });
+    }
+    pool.helpUntil(done);
+    pool.rethrowIfFailed();
+    for(size_t i = 0; i < parts.size(); ++i) {
+        shape.merge(parts[i]);
+    }
+    return shape;
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* A fork-join thread pool with work stealing. The thread that creates the
+* pool is worker 0 and the pool starts size() - 1 more threads. Each
+* worker keeps its own deque of tasks: it pushes and pops at the back, so
+* it keeps working on the most recently split (smallest, cache-warm)
+* piece, while idle workers steal from the front of other deques, where
+* the oldest and largest pieces sit.
+*
+* A task that spawns children waits for them with helpUntil(), which runs
+* other tasks instead of blocking, so no worker sits idle while work
+* remains. An exception thrown by a task is kept and rethrown from
+* rethrowIfFailed() once the work is done.
+*/
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+
+    unsigned size() const;
+
+    // Queues a task on the calling worker's deque
+    void spawn(const std::function<void()>& task);
+    // Runs queued or stolen tasks until done is set
+    void helpUntil(const std::atomic<bool>& done);
+    // Records the exception a task died with; the first one wins
+    void fail(std::exception_ptr error);
+    void rethrowIfFailed();
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    // The pool the calling thread works for and its index there
+    struct Membership
+    {
+        WorkStealingPool* pool;
+        unsigned index;
+    };
+    static Membership& membership();
+    unsigned workerIndex() const;
+
+    // Pops a task from our own deque or steals one; returns false if
+    // every deque was empty.
+    bool runOne(unsigned self);
+    void workerLoop(unsigned self);
+
+    std::vector<std::unique_ptr<Worker> > workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_;
+    std::mutex errorLock_;
+    std::exception_ptr error_;
+    Membership ownerPrevious_;   // restored when the pool goes away, so pools can nest
+};
+
+/*
+  ----------------------------------------------------
+  Begin implementations for the WorkStealingPool class.
+  ----------------------------------------------------
+*/
+
+/**
+* Starts threads - 1 workers; the calling thread is worker 0.
+*/
+inline WorkStealingPool::WorkStealingPool(unsigned threads) : stop_(false)
+{
+    if(threads == 0) {
+        threads = 1;
+    }
+    for(unsigned i = 0; i < threads; ++i) {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker));
+    }
+    ownerPrevious_ = membership();
+    membership().pool = this;
+    membership().index = 0;
+    try {
+        for(unsigned i = 1; i < threads; ++i) {
+            threads_.push_back(std::thread(&WorkStealingPool::workerLoop, this, i));
+        }
+    }
+    catch(...) {
+        // the destructor won't run, so stop the threads that did start
+        stop_.store(true, std::memory_order_release);
+        for(size_t i = 0; i < threads_.size(); ++i) {
+            threads_[i].join();
+        }
+        membership() = ownerPrevious_;
+        throw;
+    }
+}
+
+/**
+* Stops and joins the workers. Tasks must all be finished by now.
+*/
+inline WorkStealingPool::~WorkStealingPool()
+{
+    stop_.store(true, std::memory_order_release);
+    for(size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i].join();
+    }
+    membership() = ownerPrevious_;
+}
+
+inline unsigned WorkStealingPool::size() const
+{
+    return (unsigned)workers_.size();
+}
+
+inline WorkStealingPool::Membership& WorkStealingPool::membership()
+{
+    static thread_local Membership current = { NULL, 0 };
+    return current;
+}
+
+inline unsigned WorkStealingPool::workerIndex() const
+{
+    return membership().pool == this ? membership().index : 0;
+}
+
+inline void WorkStealingPool::spawn(const std::function<void()>& task)
+{
+    Worker& self = *workers_[workerIndex()];
+    std::lock_guard<std::mutex> guard(self.lock);
+    self.tasks.push_back(task);
+}
+
+inline bool WorkStealingPool::runOne(unsigned self)
+{
+    std::function<void()> task;
+    {
+        Worker& own = *workers_[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if(!own.tasks.empty()) {
+            task.swap(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+    // start with the next worker so thieves spread out over the victims
+    for(size_t i = 1; !task && i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(self + i) % workers_.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.tasks.empty()) {
+            task.swap(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if(!task) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+inline void WorkStealingPool::helpUntil(const std::atomic<bool>& done)
+{
+    unsigned self = workerIndex();
+    while(!done.load(std::memory_order_acquire)) {
+        if(!runOne(self)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+inline void WorkStealingPool::workerLoop(unsigned self)
+{
+    membership().pool = this;
+    membership().index = self;
+    while(!stop_.load(std::memory_order_acquire)) {
+        if(!runOne(self)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+inline void WorkStealingPool::fail(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> guard(errorLock_);
+    if(!error_) {
+        error_ = error;
+    }
+}
+
+inline void WorkStealingPool::rethrowIfFailed()
+{
+    std::lock_guard<std::mutex> guard(errorLock_);
+    if(error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+/*
+  --------------------------------------------------
+  End implementations for the WorkStealingPool class.
+  --------------------------------------------------
+*/
+
+#endif